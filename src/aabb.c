@@ -0,0 +1,151 @@
+#include "SDL.h"
+#include "aabb.h"
+#include "arena.h"
+#include <stdbool.h>
+#include <string.h>
+
+#ifdef AABB_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+size_t aabb_batch_count(size_t count)
+{
+    return (count + AABB_BATCH - 1) / AABB_BATCH;
+}
+
+size_t aabb_arrays_arena_size(size_t capacity)
+{
+    return ARENA_ALIGN(4 * aabb_batch_count(capacity) * AABB_BATCH *
+                       sizeof(float));
+}
+
+void aabb_arrays_init(AabbArrays *boxes, Arena *arena, size_t capacity)
+{
+    size_t stride = aabb_batch_count(capacity) * AABB_BATCH;
+    float *arrays = arena_alloc(arena, 4 * stride * sizeof(float));
+    memset(arrays, 0, 4 * stride * sizeof(float));
+
+    boxes->x = arrays;
+    boxes->y = arrays + stride;
+    boxes->w = arrays + 2 * stride;
+    boxes->h = arrays + 3 * stride;
+}
+
+void aabb_arrays_set(AabbArrays *boxes, size_t index, const SDL_FRect *box)
+{
+    boxes->x[index] = box->x;
+    boxes->y[index] = box->y;
+    boxes->w[index] = box->w;
+    boxes->h[index] = box->h;
+}
+
+/* All the kernels test the same thing SDL_HasIntersectionF does: both boxes
+ * are non-empty, and each one starts before the other one ends on both axes.
+ * The ends are computed the same way too, so the results are identical. */
+
+void aabb_intersect_scalar(const AabbArrays *boxes, size_t batch_count,
+                           const SDL_FRect *box, Uint8 *masks)
+{
+    memset(masks, 0, batch_count);
+    if (box->w <= 0 || box->h <= 0)
+        return;
+
+    float right = box->x + box->w;
+    float bottom = box->y + box->h;
+    for (size_t i = 0; i < batch_count * AABB_BATCH; i++)
+    {
+        bool hit = boxes->w[i] > 0 && boxes->h[i] > 0 &&
+                   boxes->x[i] < right && box->x < boxes->x[i] + boxes->w[i] &&
+                   boxes->y[i] < bottom && box->y < boxes->y[i] + boxes->h[i];
+        masks[i / AABB_BATCH] |= (Uint8)hit << (i % AABB_BATCH);
+    }
+}
+
+#ifdef AABB_X86_KERNELS
+__attribute__((target("sse2"))) void
+aabb_intersect_sse2(const AabbArrays *boxes, size_t batch_count,
+                    const SDL_FRect *box, Uint8 *masks)
+{
+    memset(masks, 0, batch_count);
+    if (box->w <= 0 || box->h <= 0)
+        return;
+
+    __m128 zero = _mm_setzero_ps();
+    __m128 left = _mm_set1_ps(box->x);
+    __m128 top = _mm_set1_ps(box->y);
+    __m128 right = _mm_set1_ps(box->x + box->w);
+    __m128 bottom = _mm_set1_ps(box->y + box->h);
+    for (size_t i = 0; i < batch_count * AABB_BATCH; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&boxes->x[i]);
+        __m128 y = _mm_loadu_ps(&boxes->y[i]);
+        __m128 w = _mm_loadu_ps(&boxes->w[i]);
+        __m128 h = _mm_loadu_ps(&boxes->h[i]);
+
+        __m128 hit = _mm_and_ps(_mm_cmpgt_ps(w, zero), _mm_cmpgt_ps(h, zero));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(x, right));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(left, _mm_add_ps(x, w)));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(y, bottom));
+        hit = _mm_and_ps(hit, _mm_cmplt_ps(top, _mm_add_ps(y, h)));
+
+        masks[i / AABB_BATCH] |= _mm_movemask_ps(hit) << (i % AABB_BATCH);
+    }
+}
+
+__attribute__((target("avx2"))) void
+aabb_intersect_avx2(const AabbArrays *boxes, size_t batch_count,
+                    const SDL_FRect *box, Uint8 *masks)
+{
+    memset(masks, 0, batch_count);
+    if (box->w <= 0 || box->h <= 0)
+        return;
+
+    __m256 zero = _mm256_setzero_ps();
+    __m256 left = _mm256_set1_ps(box->x);
+    __m256 top = _mm256_set1_ps(box->y);
+    __m256 right = _mm256_set1_ps(box->x + box->w);
+    __m256 bottom = _mm256_set1_ps(box->y + box->h);
+    for (size_t i = 0; i < batch_count; i++)
+    {
+        __m256 x = _mm256_loadu_ps(&boxes->x[i * AABB_BATCH]);
+        __m256 y = _mm256_loadu_ps(&boxes->y[i * AABB_BATCH]);
+        __m256 w = _mm256_loadu_ps(&boxes->w[i * AABB_BATCH]);
+        __m256 h = _mm256_loadu_ps(&boxes->h[i * AABB_BATCH]);
+
+        __m256 hit = _mm256_and_ps(_mm256_cmp_ps(w, zero, _CMP_GT_OQ),
+                                   _mm256_cmp_ps(h, zero, _CMP_GT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(x, right, _CMP_LT_OQ));
+        hit = _mm256_and_ps(
+            hit, _mm256_cmp_ps(left, _mm256_add_ps(x, w), _CMP_LT_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(y, bottom, _CMP_LT_OQ));
+        hit = _mm256_and_ps(
+            hit, _mm256_cmp_ps(top, _mm256_add_ps(y, h), _CMP_LT_OQ));
+
+        masks[i] = _mm256_movemask_ps(hit);
+    }
+}
+#endif
+
+void aabb_intersect(const AabbArrays *boxes, size_t batch_count,
+                    const SDL_FRect *box, Uint8 *masks)
+{
+    // Called from the threads of a job system, which may all pick the kernel
+    // the first time, so it's kept in an atomic pointer. They all pick the
+    // same one.
+    static void *kernel = NULL;
+    AabbIntersectFunction intersect =
+        (AabbIntersectFunction)SDL_AtomicGetPtr(&kernel);
+    if (!intersect)
+    {
+        intersect = aabb_intersect_scalar;
+#ifdef AABB_X86_KERNELS
+        if (SDL_HasAVX2())
+            intersect = aabb_intersect_avx2;
+        else if (SDL_HasSSE2())
+            intersect = aabb_intersect_sse2;
+#endif
+        SDL_AtomicSetPtr(&kernel, (void *)intersect);
+    }
+
+    intersect(boxes, batch_count, box, masks);
+}
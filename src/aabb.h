@@ -0,0 +1,98 @@
+#pragma once
+
+#include "SDL.h"
+#include "arena.h"
+#include <stddef.h>
+
+// The amount of boxes a hit mask covers.
+#define AABB_BATCH 8
+
+// Whether the x86 SIMD kernels are built (they are picked at runtime).
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AABB_X86_KERNELS
+#endif
+
+/*
+ * Axis aligned boxes as a structure of arrays, so one box can be tested
+ * against a batch of them at once. The arrays are padded with empty boxes to
+ * a whole amount of batches, and empty boxes never intersect anything.
+ */
+typedef struct AabbArrays
+{
+    float *x;
+    float *y;
+    float *w;
+    float *h;
+} AabbArrays;
+
+/*
+ * Tests a box against batches of boxes, as SDL_HasIntersectionF would. Bit i
+ * of masks[j] is set if the box intersects box j * AABB_BATCH + i.
+ */
+typedef void (*AabbIntersectFunction)(const AabbArrays *boxes,
+                                      size_t batch_count, const SDL_FRect *box,
+                                      Uint8 *masks);
+
+/**
+ * @brief Calculates the amount of arena memory aabb_arrays_init takes.
+ *
+ * @param capacity The amount of boxes.
+ */
+size_t aabb_arrays_arena_size(size_t capacity);
+
+/**
+ * @brief Allocates the arrays from an arena, all the boxes empty.
+ *
+ * @param arena The arena to allocate the arrays from, in a single allocation.
+ * @param capacity The amount of boxes the arrays hold.
+ */
+void aabb_arrays_init(AabbArrays *boxes, Arena *arena, size_t capacity);
+
+/**
+ * @brief Sets a box in the arrays.
+ *
+ * @param index The index of the box, within the capacity.
+ */
+void aabb_arrays_set(AabbArrays *boxes, size_t index, const SDL_FRect *box);
+
+/**
+ * @brief Gets the amount of batches which hold the given amount of boxes.
+ */
+size_t aabb_batch_count(size_t count);
+
+/**
+ * @brief Tests a box against batches of boxes, with the fastest kernel the
+ *          CPU supports.
+ *
+ * @see AabbIntersectFunction
+ */
+void aabb_intersect(const AabbArrays *boxes, size_t batch_count,
+                    const SDL_FRect *box, Uint8 *masks);
+
+/**
+ * @brief The kernel without SIMD, which works everywhere.
+ *
+ * @see AabbIntersectFunction
+ */
+void aabb_intersect_scalar(const AabbArrays *boxes, size_t batch_count,
+                           const SDL_FRect *box, Uint8 *masks);
+
+#ifdef AABB_X86_KERNELS
+/**
+ * @brief The SSE2 kernel, 4 boxes per instruction.
+ * @warning Only call if SDL_HasSSE2.
+ *
+ * @see AabbIntersectFunction
+ */
+void aabb_intersect_sse2(const AabbArrays *boxes, size_t batch_count,
+                         const SDL_FRect *box, Uint8 *masks);
+
+/**
+ * @brief The AVX2 kernel, 8 boxes per instruction.
+ * @warning Only call if SDL_HasAVX2.
+ *
+ * @see AabbIntersectFunction
+ */
+void aabb_intersect_avx2(const AabbArrays *boxes, size_t batch_count,
+                         const SDL_FRect *box, Uint8 *masks);
+#endif
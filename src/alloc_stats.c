@@ -0,0 +1,102 @@
+#include "alloc_stats.h"
+
+#ifdef ALLOC_STATS
+
+#include "SDL.h"
+#include <stdbool.h>
+
+struct AllocTagStats
+{
+    size_t calls;
+    size_t bytes;
+};
+
+struct AllocFrameStats
+{
+    bool started;
+    size_t frames;
+    size_t current; // Allocations in the current frame.
+    size_t total;   // Allocations in all the finished frames.
+    size_t max;
+    size_t frames_with_allocations;
+};
+
+static struct AllocTagStats tag_stats[ALLOC_TAG_COUNT];
+static size_t histogram[ALLOC_STATS_HISTOGRAM_BUCKETS];
+static struct AllocFrameStats frame_stats;
+
+static const char *const tag_names[ALLOC_TAG_COUNT] = {
+    [ALLOC_TAG_OTHER] = "other",     [ALLOC_TAG_ARENA] = "arena",
+    [ALLOC_TAG_LEVEL] = "level",     [ALLOC_TAG_TILESET] = "tileset",
+    [ALLOC_TAG_VEC] = "vec",         [ALLOC_TAG_HASHMAP] = "hashmap",
+    [ALLOC_TAG_KEYMAP] = "keymap",
+};
+
+static size_t alloc_stats_bucket(size_t size)
+{
+    size_t bucket = 0;
+    while (size > 1 && bucket < ALLOC_STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        size >>= 1;
+        bucket++;
+    }
+
+    return bucket;
+}
+
+void alloc_stats_record(AllocTag tag, size_t size)
+{
+    tag_stats[tag].calls++;
+    tag_stats[tag].bytes += size;
+    histogram[alloc_stats_bucket(size)]++;
+    frame_stats.current++;
+}
+
+void alloc_stats_frame_begin(void)
+{
+    if (frame_stats.started)
+    {
+        frame_stats.frames++;
+        frame_stats.total += frame_stats.current;
+        if (frame_stats.current > frame_stats.max)
+            frame_stats.max = frame_stats.current;
+        if (frame_stats.current > 0)
+            frame_stats.frames_with_allocations++;
+    }
+
+    frame_stats.started = true;
+    frame_stats.current = 0;
+}
+
+void alloc_stats_report(void)
+{
+    SDL_Log("Allocations by subsystem:");
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++)
+    {
+        SDL_Log("  %-8s %10zu calls %12zu bytes", tag_names[tag],
+                tag_stats[tag].calls, tag_stats[tag].bytes);
+    }
+
+    SDL_Log("Allocation sizes:");
+    for (size_t bucket = 0; bucket < ALLOC_STATS_HISTOGRAM_BUCKETS; bucket++)
+    {
+        if (!histogram[bucket])
+            continue;
+
+        if (bucket == ALLOC_STATS_HISTOGRAM_BUCKETS - 1)
+            SDL_Log("  >= %-10zu %10zu", (size_t)1 << bucket,
+                    histogram[bucket]);
+        else
+            SDL_Log("  <  %-10zu %10zu", (size_t)1 << (bucket + 1),
+                    histogram[bucket]);
+    }
+
+    SDL_Log("Allocations per frame: %.2f on average, %zu at most, in %zu "
+            "of %zu frames",
+            frame_stats.frames ? (double)frame_stats.total / frame_stats.frames
+                               : 0.0,
+            frame_stats.max, frame_stats.frames_with_allocations,
+            frame_stats.frames);
+}
+
+#endif
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Allocation instrumentation. Enabled by building with ALLOC_STATS defined
+ * (`make ALLOC_STATS=1`), otherwise all the functions compile to nothing.
+ *
+ * Every xmalloc/xrealloc is counted under the ALLOC_TAG of the translation
+ * unit it was made from. A translation unit selects its tag by defining
+ * ALLOC_TAG before any include, e.g. `#define ALLOC_TAG ALLOC_TAG_VEC`.
+ * Frees are not tracked, only the amount and the sizes of the allocations.
+ * Memory handed out by an arena counts as one allocation per block, under the
+ * tag the arena was created with: level for the arenas of a level, arena for
+ * the others (e.g. the frame arena).
+ */
+
+typedef enum AllocTag
+{
+    ALLOC_TAG_OTHER,
+    ALLOC_TAG_ARENA,
+    ALLOC_TAG_LEVEL,
+    ALLOC_TAG_TILESET,
+    ALLOC_TAG_VEC,
+    ALLOC_TAG_HASHMAP,
+    ALLOC_TAG_KEYMAP,
+    ALLOC_TAG_COUNT,
+} AllocTag;
+
+// Sizes are bucketed by powers of 2: bucket i holds sizes in [2^i, 2^(i+1)),
+// and the last bucket holds everything larger.
+#define ALLOC_STATS_HISTOGRAM_BUCKETS 24
+
+#ifdef ALLOC_STATS
+
+/**
+ * @brief Records an allocation.
+ *
+ * @param tag The subsystem that made the allocation.
+ * @param size The size of the allocation.
+ */
+void alloc_stats_record(AllocTag tag, size_t size);
+
+/**
+ * @brief Ends the current frame and starts a new one. Allocations made before
+ *          the first call are not counted towards any frame.
+ */
+void alloc_stats_frame_begin(void);
+
+/**
+ * @brief Logs the collected statistics.
+ */
+void alloc_stats_report(void);
+
+#else
+
+#define alloc_stats_record(tag, size) ((void)(tag), (void)(size))
+#define alloc_stats_frame_begin() ((void)0)
+#define alloc_stats_report() ((void)0)
+
+#endif
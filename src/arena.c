@@ -0,0 +1,108 @@
+#include "arena.h"
+#include "utils.h"
+#include <string.h>
+
+struct ArenaBlock
+{
+    ArenaBlock *prev; // NULL for the first block, which is part of the arena.
+    size_t capacity;
+    size_t used;
+    alignas(ARENA_ALIGNMENT) unsigned char data[];
+};
+
+// The first block is allocated together with the arena, right after it.
+#define ARENA_FIRST_BLOCK(arena)                                               \
+    ((ArenaBlock *)((unsigned char *)(arena) + ARENA_ALIGN(sizeof(Arena))))
+
+static void arena_block_init(ArenaBlock *block, ArenaBlock *prev,
+                             size_t capacity)
+{
+    block->prev = prev;
+    block->capacity = capacity;
+    block->used = 0;
+}
+
+Arena *arena_create(size_t capacity)
+{
+    return arena_create_tagged(ALLOC_TAG_ARENA, capacity);
+}
+
+Arena *arena_create_tagged(AllocTag tag, size_t capacity)
+{
+    capacity = ARENA_ALIGN(capacity);
+
+    Arena *arena = xmalloc_tagged(tag, ARENA_ALIGN(sizeof(Arena)) +
+                                           sizeof(ArenaBlock) + capacity);
+
+    arena->current = ARENA_FIRST_BLOCK(arena);
+    arena->block_capacity = capacity;
+    arena->used = 0;
+    arena->high_water_mark = 0;
+    arena->tag = tag;
+    arena_block_init(arena->current, NULL, capacity);
+
+    return arena;
+}
+
+/**
+ * @brief Frees all the blocks chained after the first one.
+ */
+static void arena_free_chained_blocks(Arena *arena)
+{
+    ArenaBlock *block = arena->current;
+    while (block->prev)
+    {
+        ArenaBlock *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+
+    arena->current = block;
+}
+
+void arena_destroy(Arena *arena)
+{
+    arena_free_chained_blocks(arena);
+    free(arena);
+}
+
+void arena_reset(Arena *arena)
+{
+    arena_free_chained_blocks(arena);
+    arena->current->used = 0;
+    arena->used = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = ARENA_ALIGN(size);
+
+    ArenaBlock *block = arena->current;
+    if (block->capacity - block->used < size)
+    {
+        size_t capacity =
+            size > arena->block_capacity ? size : arena->block_capacity;
+
+        block = xmalloc_tagged(arena->tag, sizeof(ArenaBlock) + capacity);
+        arena_block_init(block, arena->current, capacity);
+        arena->current = block;
+    }
+
+    void *p = &block->data[block->used];
+    block->used += size;
+
+    arena->used += size;
+    if (arena->used > arena->high_water_mark)
+        arena->high_water_mark = arena->used;
+
+    return p;
+}
+
+char *arena_strndup(Arena *arena, const char *str, size_t len)
+{
+    char *dup = arena_alloc(arena, len + 1);
+    memcpy(dup, str, len);
+    dup[len] = '\0';
+
+    return dup;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "alloc_stats.h"
+#include <stdalign.h>
+#include <stddef.h>
+
+// Every allocation from an arena is aligned to this.
+#define ARENA_ALIGNMENT (alignof(max_align_t))
+
+// The size an allocation of the given size takes up in an arena.
+#define ARENA_ALIGN(size)                                                      \
+    (((size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+typedef struct ArenaBlock ArenaBlock;
+
+/*
+ * A bump allocator. Allocations are carved one after the other out of a
+ * block of memory and are all freed at once when the arena is destroyed.
+ * When the block runs out, a new one is chained, so allocating never fails,
+ * but an arena sized right up front consists of a single allocation.
+ */
+typedef struct Arena
+{
+    ArenaBlock *current; // The block allocations are made from.
+    size_t block_capacity;
+    size_t used;            // Bytes allocated since the last reset.
+    size_t high_water_mark; // The most bytes that were ever in use at once.
+    AllocTag tag;           // What the blocks are counted as (alloc_stats.h).
+} Arena;
+
+/**
+ * @brief Creates an arena.
+ *
+ * @param capacity The amount of bytes the arena can hold before another block
+ *                  has to be allocated.
+ * @return The created arena.
+ *
+ * @see arena_destroy
+ */
+Arena *arena_create(size_t capacity);
+
+/**
+ * @brief Creates an arena whose blocks are counted under the given tag, rather
+ *          than as ALLOC_TAG_ARENA.
+ *
+ * @see arena_create
+ */
+Arena *arena_create_tagged(AllocTag tag, size_t capacity);
+
+/**
+ * @brief Frees the arena and everything allocated from it.
+ */
+void arena_destroy(Arena *arena);
+
+/**
+ * @brief Frees everything allocated from the arena, so its memory can be
+ *          reused. Blocks chained after the first one are freed.
+ *
+ * @warning All the pointers to memory allocated from the arena become invalid.
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * @brief Allocates memory from the arena.
+ *
+ * @param size The size of the memory to allocate.
+ * @return Pointer to the memory, aligned to ARENA_ALIGNMENT. Valid until the
+ *          arena is reset or destroyed. Calls `die` on failure.
+ */
+void *arena_alloc(Arena *arena, size_t size);
+
+/**
+ * @brief Copies a string into the arena.
+ *
+ * @param str The string to copy.
+ * @param len The length of the string (without the null terminator).
+ * @return Null terminated copy of the string.
+ */
+char *arena_strndup(Arena *arena, const char *str, size_t len);
@@ -0,0 +1,111 @@
+#include "SDL.h"
+#include "arena.h"
+#include "broadphase.h"
+#include "physics_world.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdbool.h>
+
+Broadphase *broadphase_create(size_t capacity)
+{
+    // The broadphase and its arrays are a single allocation.
+    size_t header_size = ARENA_ALIGN(sizeof(Broadphase));
+    size_t order_size = ARENA_ALIGN(capacity * sizeof(PhysicsBodyId));
+    Broadphase *broadphase =
+        xmalloc(header_size + order_size + capacity * sizeof(float));
+
+    broadphase->count = 0;
+    broadphase->capacity = capacity;
+    broadphase->order = (PhysicsBodyId *)((char *)broadphase + header_size);
+    broadphase->keys = (float *)((char *)broadphase->order + order_size);
+    broadphase->pairs = vector_create();
+
+    return broadphase;
+}
+
+void broadphase_destroy(Broadphase *broadphase)
+{
+    vector_free(broadphase->pairs);
+    free(broadphase);
+}
+
+/**
+ * @brief Checks if body a goes before body b in the sweep order.
+ */
+static bool broadphase_is_before(float a_key, PhysicsBodyId a, float b_key,
+                                 PhysicsBodyId b)
+{
+    return a_key < b_key || (a_key == b_key && a < b);
+}
+
+/**
+ * @brief Refreshes the keys from the bodies' current positions and sorts the
+ *          order by them. The order is almost sorted from the last update, so
+ *          each body is only moved by the few places it was overtaken by.
+ */
+static void broadphase_sort(Broadphase *broadphase, const PhysicsWorld *world)
+{
+    PhysicsBodyId *order = broadphase->order;
+    float *keys = broadphase->keys;
+    for (size_t i = 0; i < broadphase->count; i++)
+    {
+        keys[i] = world->x[order[i]];
+    }
+
+    for (size_t i = 1; i < broadphase->count; i++)
+    {
+        PhysicsBodyId body = order[i];
+        float key = keys[i];
+        size_t j = i;
+        for (; j > 0 && broadphase_is_before(key, body, keys[j - 1],
+                                             order[j - 1]);
+             j--)
+        {
+            order[j] = order[j - 1];
+            keys[j] = keys[j - 1];
+        }
+        order[j] = body;
+        keys[j] = key;
+    }
+}
+
+VecBroadphasePair broadphase_update(Broadphase *broadphase,
+                                    const PhysicsWorld *world)
+{
+    SDL_assert(world->count <= broadphase->capacity);
+
+    // New bodies start at the end, and the sort moves them into place.
+    while (broadphase->count < world->count)
+    {
+        broadphase->order[broadphase->count] = broadphase->count;
+        broadphase->count++;
+    }
+    broadphase_sort(broadphase, world);
+
+    vector_resize(&broadphase->pairs, 0);
+    const PhysicsBodyId *order = broadphase->order;
+    const float *keys = broadphase->keys;
+    for (size_t i = 0; i < broadphase->count; i++)
+    {
+        PhysicsBodyId a = order[i];
+        if (world->w[a] <= 0 || world->h[a] <= 0)
+            continue;
+
+        // Only the bodies which start before this one ends can overlap it.
+        float right = keys[i] + world->w[a];
+        float bottom = world->y[a] + world->h[a];
+        for (size_t j = i + 1; j < broadphase->count && keys[j] < right; j++)
+        {
+            PhysicsBodyId b = order[j];
+            if (world->w[b] <= 0 || world->h[b] <= 0 ||
+                world->y[b] >= bottom ||
+                world->y[a] >= world->y[b] + world->h[b])
+                continue;
+
+            BroadphasePair pair = {SDL_min(a, b), SDL_max(a, b)};
+            vector_add(&broadphase->pairs, pair);
+        }
+    }
+
+    return broadphase->pairs;
+}
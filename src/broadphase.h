@@ -0,0 +1,62 @@
+#pragma once
+
+#include "SDL.h"
+#include "physics_world.h"
+#include <stddef.h>
+
+// Two bodies whose hitboxes overlap, the lower id first.
+typedef struct BroadphasePair
+{
+    PhysicsBodyId a;
+    PhysicsBodyId b;
+} BroadphasePair;
+
+typedef BroadphasePair *VecBroadphasePair;
+
+/*
+ * Finds the pairs of bodies of a physics world which overlap, by sweep and
+ * prune on the x axis: the bodies are kept sorted by their left edge, and
+ * each one is only tested against the ones which start before it ends. The
+ * order is kept from update to update, and bodies barely move in a tick, so
+ * an insertion sort puts it back in order in about linear time.
+ *
+ * Only the bodies are in it, the static tiles are in the level's collision
+ * mesh, so they never have to be sorted.
+ */
+typedef struct Broadphase
+{
+    size_t count;
+    size_t capacity;
+    // The bodies sorted by their left edge, then by id, and the left edges
+    // themselves, as of the last update.
+    PhysicsBodyId *order;
+    float *keys;
+    VecBroadphasePair pairs; // Reused from update to update.
+} Broadphase;
+
+/**
+ * @brief Creates an empty broadphase.
+ *
+ * @param capacity The maximal amount of bodies, that of the world.
+ * @return The created broadphase.
+ *
+ * @see broadphase_destroy
+ */
+Broadphase *broadphase_create(size_t capacity);
+
+/**
+ * @brief Frees the broadphase.
+ */
+void broadphase_destroy(Broadphase *broadphase);
+
+/**
+ * @brief Sorts the bodies again after they moved, taking in the ones added
+ *          since the last update, and finds the overlapping pairs. Bodies
+ *          which only touch don't overlap, as in SDL_HasIntersectionF.
+ *
+ * @param world The world the bodies are in, always the same one.
+ * @return The pairs, in the sweep order, so always the same for the same
+ *          bodies. Valid until the next update.
+ */
+VecBroadphasePair broadphase_update(Broadphase *broadphase,
+                                    const PhysicsWorld *world);
@@ -1,39 +1,40 @@
 #pragma once
 
 #include "SDL.h"
-#include "level_layer.h"
-#include "tile.h"
-#include "vec.h"
-#include <stdint.h>
+#include "physics_world.h"
+#include <stdbool.h>
 
-typedef uint8_t CharacterMovementDirection;
+typedef PhysicsMovementDirection CharacterMovementDirection;
 
-#define CHARACTER_MOVE_LEFT (CharacterMovementDirection)0x01  // 0b01
-#define CHARACTER_MOVE_RIGHT (CharacterMovementDirection)0x02 // 0b10
+#define CHARACTER_MOVE_LEFT PHYSICS_MOVE_LEFT
+#define CHARACTER_MOVE_RIGHT PHYSICS_MOVE_RIGHT
 
-typedef uint8_t CharacterCollisionDirection;
+typedef PhysicsCollisionDirection CharacterCollisionDirection;
 
-#define CHARACTER_COLLISION_TOP (CharacterCollisionDirection)0x01
-#define CHARACTER_COLLISION_BOTTOM (CharacterCollisionDirection)0x02
-#define CHARACTER_COLLISION_LEFT (CharacterCollisionDirection)0x04
-#define CHARACTER_COLLISION_RIGHT (CharacterCollisionDirection)0x08
+#define CHARACTER_COLLISION_TOP PHYSICS_COLLISION_TOP
+#define CHARACTER_COLLISION_BOTTOM PHYSICS_COLLISION_BOTTOM
+#define CHARACTER_COLLISION_LEFT PHYSICS_COLLISION_LEFT
+#define CHARACTER_COLLISION_RIGHT PHYSICS_COLLISION_RIGHT
 
+/*
+ * A view onto a body of a physics world, which holds its hitbox, velocity,
+ * speed, movement and collisions, with what only the character has on top.
+ */
 typedef struct Character
 {
-    SDL_FRect hitbox;
-    SDL_FPoint velocity;
+    PhysicsWorld *world;
+    PhysicsBodyId body;
     SDL_Texture *texture;
-    int speed;
     int jump_strength;
-    CharacterMovementDirection movement_direction;
-    CharacterCollisionDirection collisions;
 } Character;
 
 typedef void (*MovementFunction)(Character *, CharacterMovementDirection);
 
 /**
- * @brief Creates a character
+ * @brief Creates a character, with a new body in the world.
  *
+ * @param world The world to add the character's body to. It moves the
+ *                  character when it's stepped.
  * @param texture The texture of the character.
  * @warning The caller is responsible for managing the texture.
  *
@@ -47,24 +48,16 @@ typedef void (*MovementFunction)(Character *, CharacterMovementDirection);
  *                      height.
  * @return The created character
  */
-Character *character_create(SDL_Texture *texture, SDL_FRect hitbox, int speed,
-                            int jump_strength, int scaling_factor);
+Character *character_create(PhysicsWorld *world, SDL_Texture *texture,
+                            SDL_FRect hitbox, int speed, int jump_strength,
+                            int scaling_factor);
 
 /**
  * @brief Destroys the character
- * @warning Doesn't destroy the texture.
+ * @warning Doesn't destroy the texture, and the body stays in the world.
  */
 void character_destroy(Character *character);
 
-/**
- * @brief Clamps the velocity of the character between -max_velocity and
- *          +max_velocity.
- *
- * @param max_velocity The maximum velocity the character can have in any
- *                      direction.
- */
-void character_clamp_velocity(Character *character, float max_velocity);
-
 /**
  * @brief Draws the character.
  *
@@ -76,25 +69,6 @@ void character_clamp_velocity(Character *character, float max_velocity);
 void character_draw(const Character *character, SDL_Renderer *renderer,
                     SDL_FPoint *offset);
 
-/**
- * @brief Updates character's fields and ensures they all are valid.
- *
- * @param layers Layers vector which contain tiles with which the player could
- *                  have collided.
- * @param max_acceleration The maximum acceleration the character can have.
- */
-void character_tick(Character *character, const VecLevelLayer layers,
-                    float max_acceleration);
-
-/**
- * @brief Moves the character as needed and checks that the character doesn't
- *          clip through tiles.
- *
- * @param layers Layers vector which contain tiles with which the player could
- *                  have collided.
- */
-void character_tick_movement(Character *character, const VecLevelLayer layers);
-
 /**
  * @brief Sets character's movement to the given direction, while keeping the
  *          previous movement data.
@@ -136,7 +110,7 @@ void character_unset_collision(Character *character,
  *
  * @return True if yes, false otherwise.
  */
-bool character_is_on_ground(Character *character);
+bool character_is_on_ground(const Character *character);
 
 /**
  * @brief Handles keyboard events (KEYDOWN / KEYUP) related to the character.
@@ -147,34 +121,20 @@ void character_handle_keyboard_event(Character *character,
                                    SDL_KeyboardEvent *event);
 
 /**
- * @brief Applies gravity to the character's velocity.
- *
- * @param gravity The acceleration of gravity.
- */
-void character_apply_gravity(Character *character, float gravity);
-
-/**
- * @brief Finds the collisions between the character and the tiles.
+ * @brief Gets the character position as an SDL_FPoint.
  *
- * @param tiles The tiles to find collisions with.
- * @return Vector of pointers to all the tiles player collides with.
+ * @return SDL_FPoint representing character's position.
  */
-VecTile *character_find_collisions(const Character *character,
-                                   const VecTile tiles);
+SDL_FPoint character_get_position(const Character *character);
 
 /**
- * @brief Finds the collisions between the character and the tiles in layers.
+ * @brief Moves the character to a position, e.g. a spawn point.
  *
- * @param layers Layers vector which contain tiles to find collision with.
- * @return Vector of pointers to all the tiles player collides with.
- * @see character_find_collisions
+ * @param position The new top left corner of the character's hitbox.
  */
-VecTile *character_find_collisions_with_layer_tiles(const Character *character,
-                                                    const VecLevelLayer layers);
+void character_set_position(Character *character, SDL_FPoint position);
 
 /**
- * @brief Gets the character position as an SDL_FPoint.
- *
- * @return SDL_FPoint representing character's position.
+ * @brief Gets the character's hitbox.
  */
-SDL_FPoint character_get_position(const Character *character);
+SDL_FRect character_get_hitbox(const Character *character);
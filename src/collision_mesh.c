@@ -0,0 +1,308 @@
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+
+#include "SDL.h"
+#include "aabb.h"
+#include "arena.h"
+#include "collision_mesh.h"
+#include "level_layer.h"
+#include "tile.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The amount of batches tested at once while finding collisions.
+#define COLLISION_MESH_BATCHES_PER_TEST 32
+
+typedef SDL_FRect *VecFRect;
+
+/*
+ * The cells of the level which are filled by a solid tile, all the layers
+ * together.
+ */
+struct SolidCells
+{
+    SDL_FPoint cell_size;
+    int columns, rows;
+    bool *solid; // Row by row. Cleared as the cells are merged.
+};
+
+/**
+ * @brief Finds the cell the tile fills exactly.
+ *
+ * @return False if the tile doesn't fill a single whole cell.
+ */
+static bool collision_mesh_tile_cell(const Tile *tile, SDL_FPoint cell_size,
+                                     int *column, int *row)
+{
+    if (tile->hitbox.w != cell_size.x || tile->hitbox.h != cell_size.y ||
+        tile->hitbox.x < 0 || tile->hitbox.y < 0)
+        return false;
+
+    *column = tile->hitbox.x / cell_size.x;
+    *row = tile->hitbox.y / cell_size.y;
+
+    return *column * cell_size.x == tile->hitbox.x &&
+           *row * cell_size.y == tile->hitbox.y;
+}
+
+/**
+ * @brief Marks the cells filled by solid tiles, and adds the solid tiles
+ *          which don't fill a cell to rects as they are.
+ */
+static void collision_mesh_find_solid_cells(const VecLevelLayer layers,
+                                            struct SolidCells *cells,
+                                            VecFRect *rects)
+{
+    cells->columns = cells->rows = 0;
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!level_layer_is_collidable(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            int column, row;
+            if (!tile->solid ||
+                !collision_mesh_tile_cell(tile, cells->cell_size, &column,
+                                          &row))
+                continue;
+
+            cells->columns = SDL_max(cells->columns, column + 1);
+            cells->rows = SDL_max(cells->rows, row + 1);
+        }
+    }
+
+    size_t solid_size =
+        ((size_t)cells->columns * cells->rows + 1) * sizeof(bool);
+    cells->solid = xmalloc(solid_size);
+    memset(cells->solid, 0, solid_size);
+
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!level_layer_is_collidable(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            if (!tile->solid)
+                continue;
+
+            int column, row;
+            if (collision_mesh_tile_cell(tile, cells->cell_size, &column, &row))
+                cells->solid[(size_t)row * cells->columns + column] = true;
+            else
+                vector_add(rects, tile->hitbox);
+        }
+    }
+}
+
+/**
+ * @brief Merges the solid cells into rectangles: each rectangle takes the
+ *          longest run of solid cells in its first row, and then grows down
+ *          for as long as the rows below have the same run.
+ */
+static void collision_mesh_merge_cells(struct SolidCells *cells,
+                                       VecFRect *rects)
+{
+    int columns = cells->columns;
+    bool *solid = cells->solid;
+
+    for (int row = 0; row < cells->rows; row++)
+    {
+        for (int column = 0; column < columns; column++)
+        {
+            if (!solid[(size_t)row * columns + column])
+                continue;
+
+            int width = 1;
+            while (column + width < columns &&
+                   solid[(size_t)row * columns + column + width])
+                width++;
+
+            int height = 1;
+            for (bool full = true; full && row + height < cells->rows;)
+            {
+                bool *below = &solid[(size_t)(row + height) * columns + column];
+                for (int i = 0; i < width && full; i++)
+                {
+                    full = below[i];
+                }
+
+                if (full)
+                    height++;
+            }
+
+            for (int r = row; r < row + height; r++)
+            {
+                for (int c = column; c < column + width; c++)
+                {
+                    solid[(size_t)r * columns + c] = false;
+                }
+            }
+
+            vector_add(rects, ((SDL_FRect){
+                                  column * cells->cell_size.x,
+                                  row * cells->cell_size.y,
+                                  width * cells->cell_size.x,
+                                  height * cells->cell_size.y,
+                              }));
+
+            column += width - 1;
+        }
+    }
+}
+
+/**
+ * @brief Calculates the size of an arena which fits the mesh's layer and the
+ *          hitboxes of its grid's entries.
+ *
+ * @param rects The rectangles of the mesh.
+ * @param cell_size The size of a cell of the grid.
+ */
+static size_t collision_mesh_arena_size(VecFRect rects, SDL_FPoint cell_size)
+{
+    // A rectangle is in at most one more cell than it spans on each axis,
+    // wherever the grid starts.
+    size_t max_entries = 0;
+    vector_iter(rect, rects)
+    {
+        max_entries += (size_t)(SDL_floorf(rect->w / cell_size.x) + 2) *
+                       (size_t)(SDL_floorf(rect->h / cell_size.y) + 2);
+    }
+
+    // Same as the level's arena, with a single layer (see level_arena_size).
+    // The hitboxes are read a whole batch past the last entry of a cell.
+    return ARENA_ALIGN(vector_alloc_size(0, sizeof(LevelLayer *))) +
+           vector_alloc_size(1, sizeof(LevelLayer *)) + ARENA_ALIGNMENT +
+           level_layer_arena_size(vector_size(rects)) +
+           aabb_arrays_arena_size(max_entries + AABB_BATCH - 1);
+}
+
+CollisionMesh *collision_mesh_create(const VecLevelLayer layers,
+                                     SDL_FPoint cell_size)
+{
+    VecFRect rects = vector_create();
+    struct SolidCells cells = {.cell_size = cell_size};
+    collision_mesh_find_solid_cells(layers, &cells, &rects);
+    collision_mesh_merge_cells(&cells, &rects);
+    free(cells.solid);
+
+    CollisionMesh *mesh = xmalloc(sizeof(*mesh));
+    mesh->arena = arena_create_tagged(
+        ALLOC_TAG_LEVEL, collision_mesh_arena_size(rects, cell_size));
+
+    mesh->rects = level_layer_create(mesh->arena, vector_size(rects));
+    vector_iter(rect, rects)
+    {
+        Tile tile;
+        tile_init(&tile, *rect, NULL, (TileCallback){0}, -1, 0, true);
+        level_layer_add_tile(mesh->rects, tile);
+    }
+    vector_free(rects);
+
+    mesh->layers = vector_create_in(mesh->arena);
+    // NOLINTNEXTLINE(bugprone-sizeof-expression)
+    vector_reserve(&mesh->layers, 1);
+    // NOLINTNEXTLINE(bugprone-sizeof-expression)
+    vector_add(&mesh->layers, mesh->rects);
+
+    mesh->grid = tile_grid_create(mesh->layers, cell_size, tile_is_solid);
+
+    const TileGrid *grid = mesh->grid;
+    size_t entry_count = grid->cell_offsets[(size_t)grid->columns * grid->rows];
+    aabb_arrays_init(&mesh->entry_hitboxes, mesh->arena,
+                     entry_count + AABB_BATCH - 1);
+    for (size_t i = 0; i < entry_count; i++)
+    {
+        aabb_arrays_set(&mesh->entry_hitboxes, i,
+                        &mesh->rects->tiles[grid->entries[i].tile].hitbox);
+    }
+
+    return mesh;
+}
+
+void collision_mesh_destroy(CollisionMesh *mesh)
+{
+    tile_grid_destroy(mesh->grid);
+    arena_destroy(mesh->arena);
+    free(mesh);
+}
+
+/**
+ * @brief Finds the rectangles of a cell which collide with the area, and
+ *          which aren't found from another cell of the area.
+ *
+ * @param range The cells the area overlaps.
+ */
+static void collision_mesh_find_in_cell(const CollisionMesh *mesh,
+                                        const TileGridCellRange *range,
+                                        int column, int row,
+                                        const SDL_FRect *area,
+                                        VecUint32 *collisions)
+{
+    const TileGrid *grid = mesh->grid;
+    size_t cell = (size_t)row * grid->columns + column;
+    Uint32 cell_start = grid->cell_offsets[cell];
+    Uint32 cell_end = grid->cell_offsets[cell + 1];
+    size_t batch_count = aabb_batch_count(cell_end - cell_start);
+
+    Uint8 masks[COLLISION_MESH_BATCHES_PER_TEST];
+    for (size_t first_batch = 0; first_batch < batch_count;
+         first_batch += COLLISION_MESH_BATCHES_PER_TEST)
+    {
+        // The last batch runs into the next cells, whose hits are dropped.
+        size_t first = cell_start + first_batch * AABB_BATCH;
+        AabbArrays batches = {
+            &mesh->entry_hitboxes.x[first],
+            &mesh->entry_hitboxes.y[first],
+            &mesh->entry_hitboxes.w[first],
+            &mesh->entry_hitboxes.h[first],
+        };
+        size_t count = SDL_min(batch_count - first_batch,
+                               COLLISION_MESH_BATCHES_PER_TEST);
+        aabb_intersect(&batches, count, area, masks);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            for (unsigned mask = masks[i]; mask; mask &= mask - 1)
+            {
+                size_t index = first + i * AABB_BATCH + __builtin_ctz(mask);
+                if (index >= cell_end)
+                    break;
+
+                /* A rectangle spanning several cells is only reported from
+                 * the first cell both it and the area overlap, as in
+                 * tile_grid_find_collisions. */
+                const TileGridEntry *entry = &grid->entries[index];
+                if ((row != range->first_row &&
+                     !(entry->flags & TILE_GRID_ENTRY_FIRST_ROW)) ||
+                    (column != range->first_column &&
+                     !(entry->flags & TILE_GRID_ENTRY_FIRST_COLUMN)))
+                    continue;
+
+                vector_add(collisions, entry->tile);
+            }
+        }
+    }
+}
+
+void collision_mesh_find_collisions(const CollisionMesh *mesh,
+                                    const SDL_FRect *area,
+                                    VecUint32 *collisions)
+{
+    TileGridCellRange range;
+    if (!tile_grid_cell_range(mesh->grid, area, &range))
+        return;
+
+    for (int row = range.first_row; row <= range.last_row; row++)
+    {
+        for (int column = range.first_column; column <= range.last_column;
+             column++)
+        {
+            collision_mesh_find_in_cell(mesh, &range, column, row, area,
+                                        collisions);
+        }
+    }
+}
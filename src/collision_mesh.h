@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SDL.h"
+#include "aabb.h"
+#include "arena.h"
+#include "level_layer.h"
+#include "tile_grid.h"
+
+/*
+ * The solid geometry of a level, as physics sees it. The solid tiles which
+ * fill a whole cell are greedily merged, across the collidable layers, into
+ * maximal rectangles, and the rest of the solid tiles are kept as they are.
+ * So a floor is a single rectangle, without the edges between its tiles for
+ * the character to snag on.
+ *
+ * The rectangles are solid tiles without a texture, in a layer of their own,
+ * indexed by a tile grid. The ones in an area are found by testing the area
+ * against the rectangles of each cell it overlaps, a batch at a time (see
+ * aabb_intersect).
+ */
+typedef struct CollisionMesh
+{
+    LevelLayer *rects;    // The rectangles, as tiles.
+    VecLevelLayer layers; // Only `rects`, which the grid is built over.
+    TileGrid *grid;       // The rectangles, for finding them by area.
+    // The hitbox of each entry of the grid, in the same order, so the
+    // entries of a cell are contiguous batches.
+    AabbArrays entry_hitboxes;
+    Arena *arena; // Holds the layer, the rectangles and their hitboxes.
+} CollisionMesh;
+
+typedef Uint32 *VecUint32;
+
+/**
+ * @brief Builds the collision mesh of the solid tiles in the layers.
+ *
+ * @param layers The layers of the level, as they were loaded.
+ * @param cell_size The size of a tile in the level, after scaling. The
+ *                      tiles are expected on a grid of this size from (0, 0).
+ * @return The created mesh.
+ *
+ * @see collision_mesh_destroy
+ */
+CollisionMesh *collision_mesh_create(const VecLevelLayer layers,
+                                     SDL_FPoint cell_size);
+
+/**
+ * @brief Destroys the collision mesh.
+ */
+void collision_mesh_destroy(CollisionMesh *mesh);
+
+/**
+ * @brief Finds all the rectangles which collide with the area.
+ *
+ * @param area The area to find the collisions with.
+ * @param[out] collisions The indices of the rectangles in `rects` are added
+ *                          to this vector.
+ */
+void collision_mesh_find_collisions(const CollisionMesh *mesh,
+                                    const SDL_FRect *area,
+                                    VecUint32 *collisions);
@@ -0,0 +1,131 @@
+#include "SDL.h"
+#include "frame_profiler.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// How each counter is named in the report.
+static const char *const frame_profiler_counter_names[] = {
+    [FRAME_PROFILER_ACTIVE_BODIES] = "Active bodies",
+    [FRAME_PROFILER_SLEEPING_BODIES] = "Sleeping bodies",
+};
+
+FrameProfiler *frame_profiler_create()
+{
+    FrameProfiler *profiler = xmalloc(sizeof(*profiler));
+    profiler->frame_start = 0;
+    profiler->frame_times =
+        vector_create_with_capacity(Uint64, FRAME_PROFILER_INITIAL_CAPACITY);
+    for (size_t i = 0; i < FRAME_PROFILER_COUNTER_COUNT; i++)
+    {
+        profiler->frame_counters[i] = 0;
+        profiler->counters[i] = vector_create_with_capacity(
+            Uint32, FRAME_PROFILER_INITIAL_CAPACITY);
+    }
+
+    return profiler;
+}
+
+void frame_profiler_destroy(FrameProfiler *profiler)
+{
+    vector_free(profiler->frame_times);
+    for (size_t i = 0; i < FRAME_PROFILER_COUNTER_COUNT; i++)
+    {
+        vector_free(profiler->counters[i]);
+    }
+    free(profiler);
+}
+
+void frame_profiler_begin_frame(FrameProfiler *profiler)
+{
+    profiler->frame_start = SDL_GetPerformanceCounter();
+    memset(profiler->frame_counters, 0, sizeof(profiler->frame_counters));
+}
+
+void frame_profiler_set_counter(FrameProfiler *profiler,
+                                FrameProfilerCounter counter, Uint32 value)
+{
+    profiler->frame_counters[counter] = value;
+}
+
+void frame_profiler_end_frame(FrameProfiler *profiler)
+{
+    Uint64 frame_time = SDL_GetPerformanceCounter() - profiler->frame_start;
+    vector_add(&profiler->frame_times, frame_time);
+    for (size_t i = 0; i < FRAME_PROFILER_COUNTER_COUNT; i++)
+    {
+        vector_add(&profiler->counters[i], profiler->frame_counters[i]);
+    }
+}
+
+/**
+ * @brief Converts performance counter ticks to milliseconds.
+ */
+static double frame_profiler_ms(Uint64 ticks)
+{
+    return ticks * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static int frame_profiler_compare_times(const void *a, const void *b)
+{
+    Uint64 time_a = *(const Uint64 *)a, time_b = *(const Uint64 *)b;
+    return (time_a > time_b) - (time_a < time_b);
+}
+
+void frame_profiler_report(const FrameProfiler *profiler)
+{
+    size_t count = vector_size(profiler->frame_times);
+    if (!count)
+        return;
+
+    Uint64 *sorted = xmalloc(count * sizeof(*sorted));
+    memcpy(sorted, profiler->frame_times, count * sizeof(*sorted));
+    qsort(sorted, count, sizeof(*sorted), frame_profiler_compare_times);
+
+    Uint64 total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += sorted[i];
+    }
+
+    SDL_Log("Frame times over %zu frames (ms): mean %.3f, p50 %.3f, "
+            "p90 %.3f, p99 %.3f, max %.3f",
+            count, frame_profiler_ms(total) / count,
+            frame_profiler_ms(sorted[count / 2]),
+            frame_profiler_ms(sorted[count * 90 / 100]),
+            frame_profiler_ms(sorted[count * 99 / 100]),
+            frame_profiler_ms(sorted[count - 1]));
+
+    free(sorted);
+
+    for (size_t i = 0; i < FRAME_PROFILER_COUNTER_COUNT; i++)
+    {
+        Uint64 counter_total = 0;
+        Uint32 counter_max = 0;
+        for (size_t j = 0; j < count; j++)
+        {
+            counter_total += profiler->counters[i][j];
+            counter_max = SDL_max(counter_max, profiler->counters[i][j]);
+        }
+
+        SDL_Log("%s per frame: mean %.1f, max %" SDL_PRIu32,
+                frame_profiler_counter_names[i], (double)counter_total / count,
+                counter_max);
+    }
+}
+
+void frame_profiler_write(const FrameProfiler *profiler, FILE *stream)
+{
+    for (size_t i = 0; i < vector_size(profiler->frame_times); i++)
+    {
+        fprintf(stream, "%.1f",
+                frame_profiler_ms(profiler->frame_times[i]) * 1000);
+        for (size_t j = 0; j < FRAME_PROFILER_COUNTER_COUNT; j++)
+        {
+            fprintf(stream, " %" SDL_PRIu32, profiler->counters[j][i]);
+        }
+        fputc('\n', stream);
+    }
+}
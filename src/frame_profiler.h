@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SDL.h"
+#include <stdio.h>
+
+// Room for this many frames is made up front (a minute at 60 FPS).
+#define FRAME_PROFILER_INITIAL_CAPACITY 3600
+
+typedef Uint64 *VecUint64;
+typedef Uint32 *VecUint32;
+
+// What is counted in each frame, on top of its time.
+typedef enum FrameProfilerCounter
+{
+    FRAME_PROFILER_ACTIVE_BODIES,
+    FRAME_PROFILER_SLEEPING_BODIES,
+    FRAME_PROFILER_COUNTER_COUNT,
+} FrameProfilerCounter;
+
+/*
+ * Measures how long the work of each frame takes (without waiting for the
+ * next frame), along with counts of what it did, and keeps every measurement
+ * so their distribution can be reported and compared between runs.
+ */
+typedef struct FrameProfiler
+{
+    Uint64 frame_start; // Performance counter at the start of the frame.
+    VecUint64 frame_times; // In performance counter ticks.
+    Uint32 frame_counters[FRAME_PROFILER_COUNTER_COUNT]; // Of this frame.
+    VecUint32 counters[FRAME_PROFILER_COUNTER_COUNT];    // Of every frame.
+} FrameProfiler;
+
+/**
+ * @brief Creates a frame profiler.
+ *
+ * @see frame_profiler_destroy
+ */
+FrameProfiler *frame_profiler_create();
+
+/**
+ * @brief Destroys the frame profiler.
+ */
+void frame_profiler_destroy(FrameProfiler *profiler);
+
+/**
+ * @brief Starts measuring a frame.
+ */
+void frame_profiler_begin_frame(FrameProfiler *profiler);
+
+/**
+ * @brief Sets a count of the frame being measured, 0 unless set.
+ */
+void frame_profiler_set_counter(FrameProfiler *profiler,
+                                FrameProfilerCounter counter, Uint32 value);
+
+/**
+ * @brief Ends measuring the frame started last.
+ */
+void frame_profiler_end_frame(FrameProfiler *profiler);
+
+/**
+ * @brief Logs the distribution of the frame times: the mean, percentiles and
+ *          the maximum, and the mean and maximum of each count.
+ */
+void frame_profiler_report(const FrameProfiler *profiler);
+
+/**
+ * @brief Writes the time of every frame, one per line, in microseconds,
+ *          followed by its counts, in the order of FrameProfilerCounter.
+ *
+ * @param stream The stream to write to.
+ */
+void frame_profiler_write(const FrameProfiler *profiler, FILE *stream);
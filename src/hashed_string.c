@@ -0,0 +1,30 @@
+#include "hashed_string.h"
+#include "hashmap.h"
+#include <string.h>
+
+HashedString hashed_string_make(const char *str)
+{
+    return hashed_string_make_n(str, strlen(str));
+}
+
+HashedString hashed_string_make_n(const char *str, size_t len)
+{
+    return (HashedString){
+        .str = str,
+        .len = len,
+        .hash = hashmap_hash_fast(str, len),
+    };
+}
+
+size_t hashed_string_hash(const HashedString *hashed_string)
+{
+    return hashed_string->hash;
+}
+
+int hashed_string_compare(const HashedString *a, const HashedString *b)
+{
+    if (a->hash != b->hash || a->len != b->len)
+        return 1;
+
+    return memcmp(a->str, b->str, a->len);
+}
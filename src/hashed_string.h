@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * A string together with its length and hash, computed once when it's made.
+ * Used as a hashmap key, lookups and comparisons never rehash or rescan the
+ * string. Doesn't own the string.
+ */
+typedef struct HashedString
+{
+    const char *str; // Null terminated, unless made from a part of a string
+    size_t len;
+    size_t hash;
+} HashedString;
+
+/**
+ * @brief Makes a hashed string of a null terminated string.
+ *
+ * @param str The string, which has to outlive the hashed string.
+ */
+HashedString hashed_string_make(const char *str);
+
+/**
+ * @brief Makes a hashed string of a string of known length.
+ *
+ * @param str The string, which has to outlive the hashed string. Doesn't
+ *              have to be null terminated, but then str can't be printed.
+ * @param len The length of the string.
+ */
+HashedString hashed_string_make_n(const char *str, size_t len);
+
+/**
+ * @brief The hash function for hashmaps keyed by hashed strings.
+ *
+ * @return The cached hash.
+ */
+size_t hashed_string_hash(const HashedString *hashed_string);
+
+/**
+ * @brief The compare function for hashmaps keyed by hashed strings.
+ *
+ * @return 0 if the strings are equal, non-zero otherwise.
+ */
+int hashed_string_compare(const HashedString *a, const HashedString *b);
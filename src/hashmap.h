@@ -128,6 +128,10 @@ extern "C" {
  *           Pass this directly to hashmap_init().
  *   size_t hashmap_hash_string_i(const char *key) - non-case sensitive string hash function.
  *           Pass this directly to hashmap_init().
+ *   size_t hashmap_hash_fast(const void *data, size_t len) - word-at-a-time hash (wyhash) for
+ *           keys of any data type, much faster on longer keys. Wrap it like hashmap_hash_default.
+ *   size_t hashmap_hash_string_fast(const char *key) - hashmap_hash_fast for strings.
+ *           Pass this directly to hashmap_init().
  */
 #define hashmap_init(h, hash_func, compare_func) do {                   \
     typeof((h)->map_types->t_hash_func) __map_hash = (hash_func);       \
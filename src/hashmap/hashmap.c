@@ -14,8 +14,16 @@
 #include <errno.h>
 
 #include "hashmap_base.h"
+#include "alloc_stats.h"
 
 
+/*
+ * The table implementation below uses linear probing. Building with
+ * HASHMAP_SWISS replaces it with the one in hashmap_swiss.c. The hash
+ * functions at the end of this file are shared by both.
+ */
+#ifndef HASHMAP_SWISS
+
 /* Table sizes must be powers of 2 */
 #define HASHMAP_SIZE_MIN                32
 #define HASHMAP_SIZE_DEFAULT            128
@@ -174,6 +182,7 @@ static int hashmap_rehash(struct hashmap_base *hb, size_t table_size)
     assert((table_size & (table_size - 1)) == 0);
     assert(table_size >= hb->size);
 
+    alloc_stats_record(ALLOC_TAG_HASHMAP, table_size * sizeof(struct hashmap_entry));
     new_table = (struct hashmap_entry *)calloc(table_size, sizeof(struct hashmap_entry));
     if (!new_table) {
         return -ENOMEM;
@@ -406,6 +415,8 @@ void hashmap_base_reset(struct hashmap_base *hb)
     hashmap_free_keys(hb);
     hb->size = 0;
     if (hb->table_size != hb->table_size_init) {
+        alloc_stats_record(ALLOC_TAG_HASHMAP,
+                sizeof(struct hashmap_entry) * hb->table_size_init);
         new_table = (struct hashmap_entry *)realloc(hb->table,
                 sizeof(struct hashmap_entry) * hb->table_size_init);
         if (new_table) {
@@ -596,6 +607,8 @@ double hashmap_base_collisions_variance(const struct hashmap_base *hb)
     return total_variance / hb->size;
 }
 
+#endif /* HASHMAP_SWISS */
+
 /*
  * Recommended hash function for data keys.
  *
@@ -656,3 +669,115 @@ size_t hashmap_hash_string_i(const char *key)
     hash += (hash << 15);
     return hash;
 }
+
+/*
+ * Read unaligned little-endian words for hashmap_hash_fast.
+ */
+static inline uint64_t hashmap_read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hashmap_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*
+ * Multiply two 64 bit values into a 128 bit result, and return its two
+ * halves in a (low) and b (high).
+ */
+static inline void hashmap_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl, lo, hi;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+static inline uint64_t hashmap_mix(uint64_t a, uint64_t b)
+{
+    hashmap_mum(&a, &b);
+    return a ^ b;
+}
+
+/*
+ * Fast hash function for data keys, reading the data a word at a time.
+ *
+ * This follows the algorithm of wyhash (version 4), with a fixed seed, but
+ * keeps the default secret of its earlier versions (0xa0761d64...), so its
+ * values differ from those of the reference implementation.
+ * See https://github.com/wangyi-fudan/wyhash
+ */
+size_t hashmap_hash_fast(const void *data, size_t len)
+{
+    static const uint64_t secret[4] = {
+        0xa0761d6478bd642full, 0xe7037ed1a0b428dbull,
+        0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull,
+    };
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t seed = hashmap_mix(secret[0], secret[1]);
+    uint64_t a;
+    uint64_t b;
+
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (hashmap_read32(p) << 32) | hashmap_read32(p + ((len >> 3) << 2));
+            b = (hashmap_read32(p + len - 4) << 32) |
+                hashmap_read32(p + len - 4 - ((len >> 3) << 2));
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t seed1 = seed;
+            uint64_t seed2 = seed;
+            do {
+                seed = hashmap_mix(hashmap_read64(p) ^ secret[1], hashmap_read64(p + 8) ^ seed);
+                seed1 = hashmap_mix(hashmap_read64(p + 16) ^ secret[2], hashmap_read64(p + 24) ^ seed1);
+                seed2 = hashmap_mix(hashmap_read64(p + 32) ^ secret[3], hashmap_read64(p + 40) ^ seed2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (i > 16) {
+            seed = hashmap_mix(hashmap_read64(p) ^ secret[1], hashmap_read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = hashmap_read64(p + i - 16);
+        b = hashmap_read64(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    hashmap_mum(&a, &b);
+    return (size_t)hashmap_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/*
+ * Fast hash function for string keys.
+ */
+size_t hashmap_hash_string_fast(const char *key)
+{
+    return hashmap_hash_fast(key, strlen(key));
+}
@@ -16,6 +16,9 @@ struct hashmap_base {
     size_t table_size_init;
     size_t table_size;
     size_t size;
+#ifdef HASHMAP_SWISS
+    size_t tombstones;      /* Slots of removed entries, still probed through */
+#endif
     struct hashmap_entry *table;
     size_t (*hash)(const void *);
     int (*compare)(const void *, const void *);
@@ -56,4 +59,6 @@ double hashmap_base_collisions_variance(const struct hashmap_base *hb);
 size_t hashmap_hash_default(const void *data, size_t len);
 size_t hashmap_hash_string(const char *key);
 size_t hashmap_hash_string_i(const char *key);
+size_t hashmap_hash_fast(const void *data, size_t len);
+size_t hashmap_hash_string_fast(const char *key);
 
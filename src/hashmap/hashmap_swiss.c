@@ -0,0 +1,725 @@
+/*
+ * Copyright (c) 2016-2020 David Leeds <davidesleeds@gmail.com>
+ *
+ * Hashmap is free software; you can redistribute it and/or modify
+ * it under the terms of the MIT license. See LICENSE for details.
+ */
+
+/*
+ * Swiss table backend, selected by building with HASHMAP_SWISS.
+ *
+ * Next to the entries, the table keeps one control byte per slot: either
+ * EMPTY, DELETED (a tombstone) or the low 7 bits of the entry's hash. Lookups
+ * compare a whole group of control bytes at once (with SSE2 when available),
+ * and only call the compare function for slots whose 7 hash bits and then
+ * full stored hash match. Probing moves from group to group and stops at the
+ * first group with an EMPTY slot.
+ *
+ * Removed entries leave a tombstone, so entries never move, except when the
+ * table is rehashed. As with the linear probing backend, an entry's key is
+ * NULL when its slot is not in use, which is what iteration relies on.
+ */
+
+#ifdef HASHMAP_SWISS
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "hashmap_base.h"
+#include "alloc_stats.h"
+
+
+/* Table sizes must be powers of 2, and at least one group */
+#define HASHMAP_SIZE_MIN                32
+#define HASHMAP_SIZE_DEFAULT            128
+#define HASHMAP_SIZE_MOD(map, val)      ((val) & ((map)->table_size - 1))
+
+/* The number of control bytes compared at once */
+#define HASHMAP_GROUP_WIDTH             16
+
+/* Control byte values. Slots in use hold the 7 low bits of the hash. */
+#define HASHMAP_CTRL_EMPTY              ((uint8_t)0x80)
+#define HASHMAP_CTRL_DELETED            ((uint8_t)0xFE)
+
+#define HASHMAP_H1(hash)                ((hash) >> 7)
+#define HASHMAP_H2(hash)                ((uint8_t)((hash) & 0x7F))
+
+/*
+ * The control bytes follow the entries. The first group is mirrored after
+ * the last slot, so a group can be loaded starting at any slot.
+ */
+#define HASHMAP_CTRL(map)               ((uint8_t *)&(map)->table[(map)->table_size])
+#define HASHMAP_CTRL_SIZE(table_size)   ((table_size) + HASHMAP_GROUP_WIDTH)
+
+
+struct hashmap_entry {
+    void *key;
+    void *data;
+    size_t hash;
+};
+
+/* A bit per slot of a group */
+typedef uint32_t hashmap_group_mask;
+
+
+/*
+ * Return the mask of the slots in the group whose control byte is value.
+ */
+static inline hashmap_group_mask hashmap_group_match(const uint8_t *group, uint8_t value)
+{
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+#else
+    hashmap_group_mask mask = 0;
+
+    for (int i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+        mask |= (hashmap_group_mask)(group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * Return the mask of the slots in the group which are EMPTY or DELETED.
+ * Only those control bytes have their high bit set.
+ */
+static inline hashmap_group_mask hashmap_group_match_free(const uint8_t *group)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+#else
+    hashmap_group_mask mask = 0;
+
+    for (int i = 0; i < HASHMAP_GROUP_WIDTH; ++i) {
+        mask |= (hashmap_group_mask)(group[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+/*
+ * Return the number of slots that can be in use (including tombstones)
+ * before the table has to grow. Enforces a maximum 0.875 load factor.
+ */
+static inline size_t hashmap_max_load(size_t table_size)
+{
+    return table_size - table_size / 8;
+}
+
+/*
+ * Calculate the optimal table size, given the specified max number
+ * of elements.
+ */
+static inline size_t hashmap_calc_table_size(const struct hashmap_base *hb, size_t size)
+{
+    size_t table_size;
+
+    table_size = size + (size / 7) + 1;
+
+    /* Ensure capacity is not lower than the hashmap initial size */
+    if (table_size < hb->table_size_init) {
+        table_size = hb->table_size_init;
+    } else {
+        /* Round table size up to nearest power of 2 */
+        table_size = (size_t)1 << ((sizeof(unsigned long) << 3) - __builtin_clzl(table_size - 1));
+    }
+
+    return table_size;
+}
+
+/*
+ * Hash a key. The user hash is mixed, so both the low 7 bits and the
+ * rest are usable, even if it is poorly distributed.
+ */
+static inline size_t hashmap_calc_hash(const struct hashmap_base *hb, const void *key)
+{
+    uint64_t hash = hb->hash(key);
+
+    hash *= 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 32;
+
+    return (size_t)hash;
+}
+
+/*
+ * Set the control byte of a slot, and its mirror.
+ */
+static inline void hashmap_set_ctrl(struct hashmap_base *hb, size_t index, uint8_t value)
+{
+    uint8_t *ctrl = HASHMAP_CTRL(hb);
+
+    ctrl[index] = value;
+    if (index < HASHMAP_GROUP_WIDTH) {
+        ctrl[hb->table_size + index] = value;
+    }
+}
+
+/*
+ * Mark all the slots of the table as EMPTY.
+ */
+static void hashmap_clear_table(struct hashmap_base *hb)
+{
+    memset(hb->table, 0, sizeof(struct hashmap_entry) * hb->table_size);
+    memset(HASHMAP_CTRL(hb), HASHMAP_CTRL_EMPTY, HASHMAP_CTRL_SIZE(hb->table_size));
+    hb->size = 0;
+    hb->tombstones = 0;
+}
+
+/*
+ * Return the next populated entry, starting with the specified one.
+ * Returns NULL if there are no more valid entries.
+ */
+static struct hashmap_entry *hashmap_entry_get_populated(const struct hashmap_base *hb,
+        const struct hashmap_entry *entry)
+{
+    if (hb->size > 0) {
+        for (; entry < &hb->table[hb->table_size]; ++entry) {
+            if (entry->key) {
+                return (struct hashmap_entry *)entry;
+            }
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Find the hashmap entry with the specified key and hash.
+ * Returns NULL if there is none. If probed_groups is not NULL, it is set to
+ * the number of groups probed before the one with the entry.
+ */
+static struct hashmap_entry *hashmap_entry_find(const struct hashmap_base *hb,
+    const void *key, size_t hash, size_t *probed_groups)
+{
+    const uint8_t *ctrl;
+    uint8_t h2 = HASHMAP_H2(hash);
+    size_t index;
+    size_t stride = 0;
+    size_t groups;
+    hashmap_group_mask matches;
+    struct hashmap_entry *entry;
+
+    if (!hb->table) {
+        return NULL;
+    }
+
+    ctrl = HASHMAP_CTRL(hb);
+    index = HASHMAP_SIZE_MOD(hb, HASHMAP_H1(hash));
+
+    /* Triangular probing over groups visits every group of the table */
+    for (groups = 0; groups < hb->table_size / HASHMAP_GROUP_WIDTH; ++groups) {
+        matches = hashmap_group_match(&ctrl[index], h2);
+        while (matches) {
+            entry = &hb->table[HASHMAP_SIZE_MOD(hb, index + __builtin_ctz(matches))];
+            if (entry->hash == hash && hb->compare(key, entry->key) == 0) {
+                if (probed_groups) {
+                    *probed_groups = groups;
+                }
+                return entry;
+            }
+            matches &= matches - 1;
+        }
+        if (hashmap_group_match(&ctrl[index], HASHMAP_CTRL_EMPTY)) {
+            /* The key would have been put in this group */
+            return NULL;
+        }
+        stride += HASHMAP_GROUP_WIDTH;
+        index = HASHMAP_SIZE_MOD(hb, index + stride);
+    }
+    return NULL;
+}
+
+/*
+ * Find the first EMPTY or DELETED slot on the probe sequence of the hash.
+ * The load factor guarantees there is one.
+ */
+static size_t hashmap_find_free_slot(const struct hashmap_base *hb, size_t hash)
+{
+    const uint8_t *ctrl = HASHMAP_CTRL(hb);
+    size_t index = HASHMAP_SIZE_MOD(hb, HASHMAP_H1(hash));
+    size_t stride = 0;
+    hashmap_group_mask free_slots;
+
+    for (;;) {
+        free_slots = hashmap_group_match_free(&ctrl[index]);
+        if (free_slots) {
+            return HASHMAP_SIZE_MOD(hb, index + __builtin_ctz(free_slots));
+        }
+        stride += HASHMAP_GROUP_WIDTH;
+        index = HASHMAP_SIZE_MOD(hb, index + stride);
+    }
+}
+
+/*
+ * Removes the specified entry, leaving a tombstone in its slot.
+ */
+static void hashmap_entry_remove(struct hashmap_base *hb, struct hashmap_entry *removed_entry)
+{
+    /* Free the key */
+    if (hb->key_free) {
+        hb->key_free(removed_entry->key);
+    }
+    --hb->size;
+
+    hashmap_set_ctrl(hb, removed_entry - hb->table, HASHMAP_CTRL_DELETED);
+    ++hb->tombstones;
+
+    /* Clear the entry, so iteration skips it */
+    memset(removed_entry, 0, sizeof(*removed_entry));
+}
+
+/*
+ * Reallocates the hash table to the new size and rehashes all entries,
+ * dropping all the tombstones.
+ * new_size MUST be a power of 2.
+ * Returns 0 on success and -errno on allocation failure.
+ */
+static int hashmap_rehash(struct hashmap_base *hb, size_t table_size)
+{
+    size_t old_size;
+    size_t size;
+    size_t index;
+    struct hashmap_entry *old_table;
+    struct hashmap_entry *new_table;
+    struct hashmap_entry *entry;
+
+    assert((table_size & (table_size - 1)) == 0);
+    assert(table_size >= HASHMAP_GROUP_WIDTH);
+    assert(hashmap_max_load(table_size) > hb->size);
+
+    alloc_stats_record(ALLOC_TAG_HASHMAP,
+            sizeof(struct hashmap_entry) * table_size + HASHMAP_CTRL_SIZE(table_size));
+    new_table = (struct hashmap_entry *)malloc(
+            sizeof(struct hashmap_entry) * table_size + HASHMAP_CTRL_SIZE(table_size));
+    if (!new_table) {
+        return -ENOMEM;
+    }
+    old_size = hb->table_size;
+    old_table = hb->table;
+    hb->table_size = table_size;
+    hb->table = new_table;
+
+    /* Clearing resets the size, all the entries are added back */
+    size = hb->size;
+    hashmap_clear_table(hb);
+    hb->size = size;
+
+    if (!old_table) {
+        return 0;
+    }
+
+    /* Rehash, with the stored hashes */
+    for (entry = old_table; entry < &old_table[old_size]; ++entry) {
+        if (!entry->key) {
+            continue;
+        }
+        index = hashmap_find_free_slot(hb, entry->hash);
+        hashmap_set_ctrl(hb, index, HASHMAP_H2(entry->hash));
+
+        /* Shallow copy */
+        hb->table[index] = *entry;
+    }
+    free(old_table);
+    return 0;
+}
+
+/*
+ * Iterate through all entries and free all keys.
+ */
+static void hashmap_free_keys(struct hashmap_base *hb)
+{
+    struct hashmap_entry *entry;
+
+    if (!hb->key_free || hb->size == 0) {
+        return;
+    }
+    for (entry = hb->table; entry < &hb->table[hb->table_size]; ++entry) {
+        if (entry->key) {
+            hb->key_free(entry->key);
+        }
+    }
+}
+
+/*
+ * Initialize an empty hashmap.
+ *
+ * hash_func should return an even distribution of numbers between 0
+ * and SIZE_MAX varying on the key provided.
+ *
+ * compare_func should return 0 if the keys match, and non-zero otherwise.
+ */
+void hashmap_base_init(struct hashmap_base *hb,
+        size_t (*hash_func)(const void *), int (*compare_func)(const void *, const void *))
+{
+    assert(hash_func != NULL);
+    assert(compare_func != NULL);
+
+    memset(hb, 0, sizeof(*hb));
+
+    hb->table_size_init = HASHMAP_SIZE_DEFAULT;
+    hb->hash = hash_func;
+    hb->compare = compare_func;
+}
+
+/*
+ * Free the hashmap and all associated memory.
+ */
+void hashmap_base_cleanup(struct hashmap_base *hb)
+{
+    if (!hb) {
+        return;
+    }
+    hashmap_free_keys(hb);
+    free(hb->table);
+    memset(hb, 0, sizeof(*hb));
+}
+
+/*
+ * Enable internal memory management of hash keys.
+ */
+void hashmap_base_set_key_alloc_funcs(struct hashmap_base *hb,
+    void *(*key_dup_func)(const void *),
+    void (*key_free_func)(void *))
+{
+    hb->key_dup = key_dup_func;
+    hb->key_free = key_free_func;
+}
+
+/*
+ * Set the hashmap's initial allocation size such that no rehashes are
+ * required to fit the specified number of entries.
+ * Returns 0 on success, or -errno on failure.
+ */
+int hashmap_base_reserve(struct hashmap_base *hb, size_t capacity)
+{
+    size_t old_size_init;
+    int r = 0;
+
+    /* Backup original init size in case of failure */
+    old_size_init = hb->table_size_init;
+
+    /* Set the minimal table init size to support the specified capacity */
+    hb->table_size_init = HASHMAP_SIZE_MIN;
+    hb->table_size_init = hashmap_calc_table_size(hb, capacity);
+
+    if (hb->table_size_init > hb->table_size) {
+        r = hashmap_rehash(hb, hb->table_size_init);
+        if (r < 0) {
+            hb->table_size_init = old_size_init;
+        }
+    }
+    return r;
+}
+
+/*
+ * Add a new entry to the hashmap. If an entry with a matching key
+ * already exists -EEXIST is returned.
+ * Returns 0 on success, or -errno on failure.
+ */
+int hashmap_base_put(struct hashmap_base *hb, const void *key, void *data)
+{
+    struct hashmap_entry *entry;
+    size_t table_size;
+    size_t hash;
+    size_t index;
+    int r;
+
+    if (!key || !data) {
+        return -EINVAL;
+    }
+
+    /*
+     * Rehash if the new entry would exceed the load factor. Tombstones count
+     * towards it, as they are probed through. If they are what fills the
+     * table, it is rehashed at the same size to drop them.
+     */
+    if (hb->size + hb->tombstones + 1 > hashmap_max_load(hb->table_size)) {
+        table_size = hashmap_calc_table_size(hb, hb->size + 1);
+        if (table_size < hb->table_size) {
+            table_size = hb->table_size;
+        }
+        r = hashmap_rehash(hb, table_size);
+        if (r < 0) {
+            return r;
+        }
+    }
+
+    hash = hashmap_calc_hash(hb, key);
+    if (hashmap_entry_find(hb, key, hash, NULL)) {
+        /* Do not overwrite existing data */
+        return -EEXIST;
+    }
+
+    index = hashmap_find_free_slot(hb, hash);
+    entry = &hb->table[index];
+
+    if (hb->key_dup) {
+        /* Allocate copy of key to simplify memory management */
+        entry->key = hb->key_dup(key);
+        if (!entry->key) {
+            return -ENOMEM;
+        }
+    } else {
+        entry->key = (void *)key;
+    }
+    entry->data = data;
+    entry->hash = hash;
+
+    if (HASHMAP_CTRL(hb)[index] == HASHMAP_CTRL_DELETED) {
+        --hb->tombstones;
+    }
+    hashmap_set_ctrl(hb, index, HASHMAP_H2(hash));
+    ++hb->size;
+    return 0;
+}
+
+/*
+ * Return the data pointer, or NULL if no entry exists.
+ */
+void *hashmap_base_get(const struct hashmap_base *hb, const void *key)
+{
+    struct hashmap_entry *entry;
+
+    if (!key || !hb->table) {
+        return NULL;
+    }
+
+    entry = hashmap_entry_find(hb, key, hashmap_calc_hash(hb, key), NULL);
+    if (!entry) {
+        return NULL;
+    }
+    return entry->data;
+}
+
+/*
+ * Remove an entry with the specified key from the map.
+ * Returns the data pointer, or NULL, if no entry was found.
+ */
+void *hashmap_base_remove(struct hashmap_base *hb, const void *key)
+{
+    struct hashmap_entry *entry;
+    void *data;
+
+    if (!key || !hb->table) {
+        return NULL;
+    }
+
+    entry = hashmap_entry_find(hb, key, hashmap_calc_hash(hb, key), NULL);
+    if (!entry) {
+        return NULL;
+    }
+    data = entry->data;
+    hashmap_entry_remove(hb, entry);
+    return data;
+}
+
+/*
+ * Remove all entries.
+ */
+void hashmap_base_clear(struct hashmap_base *hb)
+{
+    hashmap_free_keys(hb);
+    if (hb->table) {
+        hashmap_clear_table(hb);
+    }
+}
+
+/*
+ * Remove all entries and reset the hash table to its initial size.
+ */
+void hashmap_base_reset(struct hashmap_base *hb)
+{
+    struct hashmap_entry *new_table;
+
+    hashmap_free_keys(hb);
+    if (hb->table && hb->table_size != hb->table_size_init) {
+        alloc_stats_record(ALLOC_TAG_HASHMAP,
+                sizeof(struct hashmap_entry) * hb->table_size_init +
+                HASHMAP_CTRL_SIZE(hb->table_size_init));
+        new_table = (struct hashmap_entry *)realloc(hb->table,
+                sizeof(struct hashmap_entry) * hb->table_size_init +
+                HASHMAP_CTRL_SIZE(hb->table_size_init));
+        if (new_table) {
+            hb->table = new_table;
+            hb->table_size = hb->table_size_init;
+        }
+    }
+    if (hb->table) {
+        hashmap_clear_table(hb);
+    }
+}
+
+/*
+ * Get a new hashmap iterator. The iterator is an opaque
+ * pointer that may be used with hashmap_iter_*() functions.
+ * Hashmap iterators are INVALID after a put or remove operation is performed.
+ * hashmap_iter_remove() allows safe removal during iteration.
+ */
+struct hashmap_entry *hashmap_base_iter(const struct hashmap_base *hb,
+        const struct hashmap_entry *pos)
+{
+    if (!pos) {
+        pos = hb->table;
+    }
+    return hashmap_entry_get_populated(hb, pos);
+}
+
+/*
+ * Return true if an iterator is valid and safe to use.
+ */
+bool hashmap_base_iter_valid(const struct hashmap_base *hb, const struct hashmap_entry *iter)
+{
+    return hb && iter && iter->key && iter >= hb->table && iter < &hb->table[hb->table_size];
+}
+
+/*
+ * Advance an iterator to the next hashmap entry.
+ * Returns false if there are no more entries.
+ */
+bool hashmap_base_iter_next(const struct hashmap_base *hb, struct hashmap_entry **iter)
+{
+    if (!*iter) {
+        return false;
+    }
+    return (*iter = hashmap_entry_get_populated(hb, *iter + 1)) != NULL;
+}
+
+/*
+ * Remove the hashmap entry pointed to by this iterator and advance the
+ * iterator to the next entry.
+ * Returns true if the iterator is valid after the operation.
+ */
+bool hashmap_base_iter_remove(struct hashmap_base *hb, struct hashmap_entry **iter)
+{
+    if (!*iter) {
+        return false;
+    }
+    if ((*iter)->key) {
+        /* Remove entry if iterator is valid */
+        hashmap_entry_remove(hb, *iter);
+    }
+    return (*iter = hashmap_entry_get_populated(hb, *iter)) != NULL;
+}
+
+/*
+ * Return the key of the entry pointed to by the iterator.
+ */
+const void *hashmap_base_iter_get_key(const struct hashmap_entry *iter)
+{
+    if (!iter) {
+        return NULL;
+    }
+    return (const void *)iter->key;
+}
+
+/*
+ * Return the data of the entry pointed to by the iterator.
+ */
+void *hashmap_base_iter_get_data(const struct hashmap_entry *iter)
+{
+    if (!iter) {
+        return NULL;
+    }
+    return iter->data;
+}
+
+/*
+ * Set the data pointer of the entry pointed to by the iterator.
+ */
+int hashmap_base_iter_set_data(struct hashmap_entry *iter, void *data)
+{
+    if (!iter) {
+        return -EFAULT;
+    }
+    if (!data) {
+        return -EINVAL;
+    }
+    iter->data = data;
+    return 0;
+}
+
+/*
+ * Return the load factor.
+ */
+double hashmap_base_load_factor(const struct hashmap_base *hb)
+{
+    if (!hb->table_size) {
+        return 0;
+    }
+    return (double)hb->size / hb->table_size;
+}
+
+/*
+ * Return the number of collisions for this key: the number of groups probed
+ * before the one the key is in.
+ */
+size_t hashmap_base_collisions(const struct hashmap_base *hb, const void *key)
+{
+    size_t probed_groups = 0;
+
+    if (!key) {
+        return 0;
+    }
+
+    if (!hashmap_entry_find(hb, key, hashmap_calc_hash(hb, key), &probed_groups)) {
+        /* Key does not exist */
+        return 0;
+    }
+    return probed_groups;
+}
+
+/*
+ * Return the average number of collisions per entry.
+ */
+double hashmap_base_collisions_mean(const struct hashmap_base *hb)
+{
+    struct hashmap_entry *entry;
+    size_t total_collisions = 0;
+
+    if (!hb->size) {
+        return 0;
+    }
+    for (entry = hb->table; entry < &hb->table[hb->table_size]; ++entry) {
+        if (!entry->key) {
+            continue;
+        }
+
+        total_collisions += hashmap_base_collisions(hb, entry->key);
+    }
+    return (double)total_collisions / hb->size;
+}
+
+/*
+ * Return the variance between entry collisions. The higher the variance,
+ * the more likely the hash function is poor and is resulting in clustering.
+ */
+double hashmap_base_collisions_variance(const struct hashmap_base *hb)
+{
+    struct hashmap_entry *entry;
+    double mean_collisions;
+    double variance;
+    double total_variance = 0;
+
+    if (!hb->size) {
+        return 0;
+    }
+    mean_collisions = hashmap_base_collisions_mean(hb);
+    for (entry = hb->table; entry < &hb->table[hb->table_size]; ++entry) {
+        if (!entry->key) {
+            continue;
+        }
+        variance = (double)hashmap_base_collisions(hb, entry->key) - mean_collisions;
+        total_variance += variance * variance;
+    }
+    return total_variance / hb->size;
+}
+
+#endif /* HASHMAP_SWISS */
@@ -0,0 +1,153 @@
+#include "SDL.h"
+#include "input_replay.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+InputRecorder *input_recorder_open(const char *path, uint64_t seed)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return NULL;
+
+    InputReplayHeader header = {.seed = SDL_SwapLE64(seed)};
+    memcpy(header.magic, INPUT_REPLAY_MAGIC, INPUT_REPLAY_MAGIC_SIZE);
+    fwrite(&header, sizeof(header), 1, file);
+
+    InputRecorder *recorder = xmalloc(sizeof(*recorder));
+    recorder->file = file;
+
+    return recorder;
+}
+
+/**
+ * @brief Writes a record in little endian.
+ */
+static void input_recorder_write(InputRecorder *recorder,
+                                 InputReplayRecord record)
+{
+    record.tick = SDL_SwapLE32(record.tick);
+    record.sym = SDL_SwapLE32(record.sym);
+    record.scancode = SDL_SwapLE16(record.scancode);
+
+    fwrite(&record, sizeof(record), 1, recorder->file);
+}
+
+void input_recorder_record(InputRecorder *recorder, uint32_t tick,
+                           const SDL_KeyboardEvent *event)
+{
+    input_recorder_write(recorder,
+                         (InputReplayRecord){
+                             .tick = tick,
+                             .sym = event->keysym.sym,
+                             .scancode = event->keysym.scancode,
+                             .type = event->type == SDL_KEYDOWN
+                                         ? INPUT_REPLAY_KEY_DOWN
+                                         : INPUT_REPLAY_KEY_UP,
+                             .repeat = event->repeat,
+                         });
+}
+
+void input_recorder_close(InputRecorder *recorder, uint32_t tick)
+{
+    input_recorder_write(recorder, (InputReplayRecord){
+                                       .tick = tick,
+                                       .type = INPUT_REPLAY_END,
+                                   });
+
+    if (fclose(recorder->file))
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "Saving the recording failed");
+    }
+
+    free(recorder);
+}
+
+InputPlayer *input_player_open(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    size_t size = 0;
+    char *buf = read_stream(file, &size);
+    fclose(file);
+
+    InputReplayHeader header;
+    if (size < sizeof(header) ||
+        memcmp(buf, INPUT_REPLAY_MAGIC, INPUT_REPLAY_MAGIC_SIZE) != 0)
+    {
+        free(buf);
+        return NULL;
+    }
+    memcpy(&header, buf, sizeof(header));
+
+    size_t record_count = (size - sizeof(header)) / sizeof(InputReplayRecord);
+
+    // Room for an end record, in case the recording was cut short.
+    InputPlayer *player = xmalloc(sizeof(*player));
+    player->seed = SDL_SwapLE64(header.seed);
+    player->records = xmalloc((record_count + 1) * sizeof(InputReplayRecord));
+    player->next_record = 0;
+    memcpy(player->records, buf + sizeof(header),
+           record_count * sizeof(InputReplayRecord));
+    free(buf);
+
+    uint32_t last_tick = 0;
+    for (size_t i = 0; i < record_count; i++)
+    {
+        InputReplayRecord *record = &player->records[i];
+        record->tick = SDL_SwapLE32(record->tick);
+        record->sym = SDL_SwapLE32(record->sym);
+        record->scancode = SDL_SwapLE16(record->scancode);
+        last_tick = record->tick;
+    }
+
+    if (!record_count ||
+        player->records[record_count - 1].type != INPUT_REPLAY_END)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                    "The recording %s is cut short, playing until tick %u",
+                    path, last_tick);
+        player->records[record_count] = (InputReplayRecord){
+            .tick = last_tick,
+            .type = INPUT_REPLAY_END,
+        };
+    }
+
+    return player;
+}
+
+void input_player_destroy(InputPlayer *player)
+{
+    free(player->records);
+    free(player);
+}
+
+bool input_player_poll(InputPlayer *player, uint32_t tick, SDL_Event *event)
+{
+    const InputReplayRecord *record = &player->records[player->next_record];
+    if (record->type == INPUT_REPLAY_END || record->tick > tick)
+        return false;
+
+    player->next_record++;
+
+    *event = (SDL_Event){0};
+    event->key.type =
+        record->type == INPUT_REPLAY_KEY_DOWN ? SDL_KEYDOWN : SDL_KEYUP;
+    event->key.state =
+        record->type == INPUT_REPLAY_KEY_DOWN ? SDL_PRESSED : SDL_RELEASED;
+    event->key.repeat = record->repeat;
+    event->key.keysym.sym = record->sym;
+    event->key.keysym.scancode = record->scancode;
+
+    return true;
+}
+
+bool input_player_is_done(const InputPlayer *player, uint32_t tick)
+{
+    const InputReplayRecord *record = &player->records[player->next_record];
+    return record->type == INPUT_REPLAY_END && tick >= record->tick;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "SDL.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Records the keyboard input of a run, keyed by tick (frame) number, along
+ * with the random seed, and plays it back. Playing back a recording with the
+ * same build repeats the run exactly, so runs can be compared across builds.
+ *
+ * The file is a header followed by a record per keyboard event, all little
+ * endian. The last record marks the tick the recording ended on.
+ */
+
+#define INPUT_REPLAY_MAGIC "RPL1"
+#define INPUT_REPLAY_MAGIC_SIZE 4
+
+typedef enum InputReplayRecordType
+{
+    INPUT_REPLAY_KEY_DOWN,
+    INPUT_REPLAY_KEY_UP,
+    INPUT_REPLAY_END,
+} InputReplayRecordType;
+
+typedef struct InputReplayHeader
+{
+    char magic[INPUT_REPLAY_MAGIC_SIZE];
+    uint32_t padding;
+    uint64_t seed;
+} InputReplayHeader;
+
+typedef struct InputReplayRecord
+{
+    uint32_t tick;
+    int32_t sym;       // SDL_Keycode
+    uint16_t scancode; // SDL_Scancode
+    uint8_t type;      // InputReplayRecordType
+    uint8_t repeat;
+} InputReplayRecord;
+
+_Static_assert(sizeof(InputReplayHeader) == 16, "No padding in the file");
+_Static_assert(sizeof(InputReplayRecord) == 12, "No padding in the file");
+
+typedef struct InputRecorder
+{
+    FILE *file;
+} InputRecorder;
+
+typedef struct InputPlayer
+{
+    uint64_t seed;
+    InputReplayRecord *records; // Ends with an INPUT_REPLAY_END record.
+    size_t next_record;
+} InputPlayer;
+
+/**
+ * @brief Starts recording into a file.
+ *
+ * @param path The path of the recording, overwritten if it exists.
+ * @param seed The random seed of the run.
+ * @return The recorder, or NULL if the file couldn't be opened.
+ *
+ * @see input_recorder_close
+ */
+InputRecorder *input_recorder_open(const char *path, uint64_t seed);
+
+/**
+ * @brief Records a keyboard event.
+ *
+ * @param tick The tick the event is handled on.
+ * @param event The event (KEYDOWN / KEYUP).
+ */
+void input_recorder_record(InputRecorder *recorder, uint32_t tick,
+                           const SDL_KeyboardEvent *event);
+
+/**
+ * @brief Ends the recording, and closes the file.
+ *
+ * @param tick The last tick of the run.
+ */
+void input_recorder_close(InputRecorder *recorder, uint32_t tick);
+
+/**
+ * @brief Loads a recording for playback.
+ *
+ * @param path The path of the recording.
+ * @return The player, or NULL if the file couldn't be read or isn't a
+ *          recording.
+ *
+ * @see input_player_destroy
+ */
+InputPlayer *input_player_open(const char *path);
+
+/**
+ * @brief Destroys the player.
+ */
+void input_player_destroy(InputPlayer *player);
+
+/**
+ * @brief Gets the next recorded event of a tick.
+ *
+ * @param tick The current tick. Must not go backwards between calls.
+ * @param[out] event The event, as it was recorded.
+ * @return True if there was an event, false if all the events of the tick
+ *          were played.
+ */
+bool input_player_poll(InputPlayer *player, uint32_t tick, SDL_Event *event);
+
+/**
+ * @brief Checks if the recording has ended by the given tick.
+ */
+bool input_player_is_done(const InputPlayer *player, uint32_t tick);
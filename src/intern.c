@@ -0,0 +1,76 @@
+#include "arena.h"
+#include "hashmap.h"
+#include "intern.h"
+#include "utils.h"
+#include <errno.h>
+#include <string.h>
+
+typedef HASHMAP(HashedString, HashedString) InternPoolHashmap;
+
+struct InternPool
+{
+    Arena *arena;
+    // From the contents of a string to its handle, which is also the key.
+    InternPoolHashmap strings;
+};
+
+static struct InternPool intern_pool;
+
+InternedString intern_find(const char *str, size_t len)
+{
+    if (!intern_pool.arena)
+        return NULL;
+
+    HashedString key = hashed_string_make_n(str, len);
+    return hashmap_get(&intern_pool.strings, &key);
+}
+
+InternedString intern(const char *str, size_t len)
+{
+    if (!intern_pool.arena)
+    {
+        intern_pool.arena = arena_create(INTERN_POOL_BLOCK_SIZE);
+        hashmap_init(&intern_pool.strings, hashed_string_hash,
+                     hashed_string_compare);
+    }
+
+    HashedString key = hashed_string_make_n(str, len);
+    HashedString *interned = hashmap_get(&intern_pool.strings, &key);
+    if (interned)
+        return interned;
+
+    interned = arena_alloc(intern_pool.arena, sizeof(*interned));
+    *interned = key;
+    interned->str = arena_strndup(intern_pool.arena, str, len);
+
+    int err = hashmap_put(&intern_pool.strings, interned, interned);
+    if (err)
+        die("Interning %s failed: %s", interned->str, strerror(-err));
+
+    return interned;
+}
+
+InternedString intern_cstr(const char *str)
+{
+    return intern(str, strlen(str));
+}
+
+void intern_pool_destroy(void)
+{
+    if (!intern_pool.arena)
+        return;
+
+    hashmap_cleanup(&intern_pool.strings);
+    arena_destroy(intern_pool.arena);
+    intern_pool.arena = NULL;
+}
+
+size_t interned_string_hash(const HashedString *interned)
+{
+    return interned->hash;
+}
+
+int interned_string_compare(const HashedString *a, const HashedString *b)
+{
+    return a != b;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "hashed_string.h"
+#include <stddef.h>
+
+// The size of each block of the interning pool's arena.
+#define INTERN_POOL_BLOCK_SIZE 4096
+
+/*
+ * A global pool of interned strings. Interning a string returns a handle
+ * which is the same for all equal strings and stays valid until the pool is
+ * destroyed. So interned strings are compared by comparing the handles, and
+ * their hash is already computed. The strings are stored in an arena.
+ */
+typedef const HashedString *InternedString;
+
+/**
+ * @brief Interns a string. The pool is created on first use.
+ *
+ * @param str The string, doesn't have to be null terminated (e.g. a part of
+ *              a parse buffer). It's copied if it's not in the pool yet.
+ * @param len The length of the string.
+ * @return The handle of the string. Its str is null terminated.
+ *
+ * @see intern_pool_destroy
+ */
+InternedString intern(const char *str, size_t len);
+
+/**
+ * @brief Interns a null terminated string.
+ *
+ * @see intern
+ */
+InternedString intern_cstr(const char *str);
+
+/**
+ * @brief Finds the handle of a string without interning it.
+ *
+ * @return The handle of the string, or NULL if it wasn't interned.
+ */
+InternedString intern_find(const char *str, size_t len);
+
+/**
+ * @brief Frees all the interned strings.
+ *
+ * @warning All the handles become invalid.
+ */
+void intern_pool_destroy(void);
+
+/**
+ * @brief The hash function for hashmaps keyed by interned strings.
+ */
+size_t interned_string_hash(const HashedString *interned);
+
+/**
+ * @brief The compare function for hashmaps keyed by interned strings.
+ *          Compares the handles only.
+ */
+int interned_string_compare(const HashedString *a, const HashedString *b);
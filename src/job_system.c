@@ -0,0 +1,275 @@
+#include "SDL.h"
+#include "arena.h"
+#include "job_system.h"
+#include "utils.h"
+#include <stdbool.h>
+
+typedef struct JobRange
+{
+    size_t first, last;
+} JobRange;
+
+typedef struct JobWorker
+{
+    JobSystem *jobs;
+    SDL_Thread *thread; // NULL for the calling thread, which is worker 0.
+    Arena *scratch;
+
+    // The deque holds ranges[top..bottom). The owner takes from the bottom,
+    // the thieves from the top, both under the lock.
+    SDL_SpinLock lock;
+    size_t top, bottom;
+    JobRange ranges[JOB_SYSTEM_DEQUE_CAPACITY];
+} JobWorker;
+
+struct JobSystem
+{
+    int thread_count;
+    JobWorker *workers;
+
+    SDL_mutex *mutex;
+    SDL_cond *work_posted;
+    SDL_cond *work_done;
+    SDL_cond *workers_parked;
+    Uint32 generation; // Incremented for each parallel for, under the mutex.
+    int busy_workers;  // The worker threads looking for ranges, ditto.
+    bool quitting;
+
+    // The current parallel for.
+    JobFunction function;
+    void *data;
+    SDL_atomic_t remaining; // The amount of ranges which aren't done yet.
+};
+
+/**
+ * @brief Takes the range at the bottom of the worker's own deque.
+ *
+ * @return False if the deque is empty.
+ */
+static bool job_worker_pop(JobWorker *worker, JobRange *range)
+{
+    SDL_AtomicLock(&worker->lock);
+    bool found = worker->top < worker->bottom;
+    if (found)
+        *range = worker->ranges[--worker->bottom];
+    SDL_AtomicUnlock(&worker->lock);
+
+    return found;
+}
+
+/**
+ * @brief Takes the range at the top of another worker's deque.
+ *
+ * @return False if the deque is empty.
+ */
+static bool job_worker_steal(JobWorker *victim, JobRange *range)
+{
+    SDL_AtomicLock(&victim->lock);
+    bool found = victim->top < victim->bottom;
+    if (found)
+        *range = victim->ranges[victim->top++];
+    SDL_AtomicUnlock(&victim->lock);
+
+    return found;
+}
+
+/**
+ * @brief Runs ranges of the current parallel for, its own and then stolen
+ *          ones, until there are none left to take.
+ */
+static void job_system_work(JobSystem *jobs, int worker_index)
+{
+    JobWorker *worker = &jobs->workers[worker_index];
+    for (;;)
+    {
+        JobRange range;
+        bool found = job_worker_pop(worker, &range);
+        for (int i = 1; !found && i < jobs->thread_count; i++)
+        {
+            int victim = (worker_index + i) % jobs->thread_count;
+            found = job_worker_steal(&jobs->workers[victim], &range);
+        }
+        if (!found)
+            return;
+
+        jobs->function(jobs->data, range.first, range.last, worker->scratch);
+
+        if (SDL_AtomicAdd(&jobs->remaining, -1) == 1)
+        {
+            SDL_LockMutex(jobs->mutex);
+            SDL_CondSignal(jobs->work_done);
+            SDL_UnlockMutex(jobs->mutex);
+        }
+    }
+}
+
+/**
+ * @brief The loop of a worker thread: waits for a parallel for, works on it,
+ *          and waits for the next one.
+ */
+static int job_worker_run(void *data)
+{
+    JobWorker *worker = data;
+    JobSystem *jobs = worker->jobs;
+    int worker_index = (int)(worker - jobs->workers);
+
+    Uint32 generation = 0;
+    SDL_LockMutex(jobs->mutex);
+    for (;;)
+    {
+        while (!jobs->quitting && jobs->generation == generation)
+            SDL_CondWait(jobs->work_posted, jobs->mutex);
+        if (jobs->quitting)
+            break;
+
+        generation = jobs->generation;
+        jobs->busy_workers++;
+        SDL_UnlockMutex(jobs->mutex);
+        job_system_work(jobs, worker_index);
+        SDL_LockMutex(jobs->mutex);
+        if (--jobs->busy_workers == 0)
+            SDL_CondSignal(jobs->workers_parked);
+    }
+    SDL_UnlockMutex(jobs->mutex);
+
+    return 0;
+}
+
+JobSystem *job_system_create(int thread_count)
+{
+    if (thread_count <= 0)
+        thread_count = SDL_max(SDL_GetCPUCount(), 1);
+
+    JobSystem *jobs = xmalloc(sizeof(*jobs));
+    jobs->thread_count = thread_count;
+    jobs->workers = xmalloc(thread_count * sizeof(*jobs->workers));
+    jobs->mutex = SDL_CreateMutex();
+    jobs->work_posted = SDL_CreateCond();
+    jobs->work_done = SDL_CreateCond();
+    jobs->workers_parked = SDL_CreateCond();
+    if (!jobs->mutex || !jobs->work_posted || !jobs->work_done ||
+        !jobs->workers_parked)
+        die("Creating the job system failed: %s", SDL_GetError());
+    jobs->generation = 0;
+    jobs->busy_workers = 0;
+    jobs->quitting = false;
+    jobs->function = NULL;
+    jobs->data = NULL;
+    SDL_AtomicSet(&jobs->remaining, 0);
+
+    for (int i = 0; i < thread_count; i++)
+    {
+        JobWorker *worker = &jobs->workers[i];
+        worker->jobs = jobs;
+        worker->thread = NULL;
+        worker->scratch = arena_create(JOB_SYSTEM_SCRATCH_SIZE);
+        worker->lock = 0;
+        worker->top = worker->bottom = 0;
+    }
+
+    // Worker 0 is the thread which calls parallel for.
+    for (int i = 1; i < thread_count; i++)
+    {
+        JobWorker *worker = &jobs->workers[i];
+        worker->thread = SDL_CreateThread(job_worker_run, "job worker", worker);
+        if (!worker->thread)
+            die("SDL_CreateThread: %s", SDL_GetError());
+    }
+
+    return jobs;
+}
+
+void job_system_destroy(JobSystem *jobs)
+{
+    SDL_LockMutex(jobs->mutex);
+    jobs->quitting = true;
+    SDL_CondBroadcast(jobs->work_posted);
+    SDL_UnlockMutex(jobs->mutex);
+
+    for (int i = 0; i < jobs->thread_count; i++)
+    {
+        if (jobs->workers[i].thread)
+            SDL_WaitThread(jobs->workers[i].thread, NULL);
+        arena_destroy(jobs->workers[i].scratch);
+    }
+
+    SDL_DestroyCond(jobs->workers_parked);
+    SDL_DestroyCond(jobs->work_done);
+    SDL_DestroyCond(jobs->work_posted);
+    SDL_DestroyMutex(jobs->mutex);
+    free(jobs->workers);
+    free(jobs);
+}
+
+int job_system_thread_count(const JobSystem *jobs)
+{
+    return jobs->thread_count;
+}
+
+void job_system_parallel_for(JobSystem *jobs, size_t count, size_t grain,
+                             JobFunction function, void *data)
+{
+    if (!count)
+        return;
+
+    grain = SDL_max(grain, 1);
+    size_t max_ranges = (size_t)jobs->thread_count * JOB_SYSTEM_DEQUE_CAPACITY;
+    if ((count + grain - 1) / grain > max_ranges)
+        grain = (count + max_ranges - 1) / max_ranges;
+    size_t range_count = (count + grain - 1) / grain;
+
+    // Waking the workers isn't worth it for a single range.
+    if (range_count == 1 || jobs->thread_count == 1)
+    {
+        arena_reset(jobs->workers[0].scratch);
+        function(data, 0, count, jobs->workers[0].scratch);
+        return;
+    }
+
+    // The ranges of the previous parallel for are done, but a worker may still
+    // be looking for more, e.g. one which only woke up for it once it was
+    // over. Once they are all parked, none starts looking again before the
+    // mutex is released, so the job and the scratch arenas are free to
+    // change.
+    SDL_LockMutex(jobs->mutex);
+    while (jobs->busy_workers > 0)
+        SDL_CondWait(jobs->workers_parked, jobs->mutex);
+
+    jobs->function = function;
+    jobs->data = data;
+    SDL_AtomicSet(&jobs->remaining, (int)range_count);
+
+    // Each worker gets a contiguous share of the ranges, pushed from the last
+    // so it works through them in order, while thieves take them from the
+    // end.
+    for (int i = 0; i < jobs->thread_count; i++)
+    {
+        JobWorker *worker = &jobs->workers[i];
+        size_t first_range = range_count * i / jobs->thread_count;
+        size_t last_range = range_count * (i + 1) / jobs->thread_count;
+
+        arena_reset(worker->scratch);
+
+        SDL_AtomicLock(&worker->lock);
+        worker->top = worker->bottom = 0;
+        for (size_t r = last_range; r-- > first_range;)
+        {
+            worker->ranges[worker->bottom++] = (JobRange){
+                r * grain,
+                SDL_min((r + 1) * grain, count),
+            };
+        }
+        SDL_AtomicUnlock(&worker->lock);
+    }
+
+    jobs->generation++;
+    SDL_CondBroadcast(jobs->work_posted);
+    SDL_UnlockMutex(jobs->mutex);
+
+    job_system_work(jobs, 0);
+
+    SDL_LockMutex(jobs->mutex);
+    while (SDL_AtomicGet(&jobs->remaining) > 0)
+        SDL_CondWait(jobs->work_done, jobs->mutex);
+    SDL_UnlockMutex(jobs->mutex);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SDL.h"
+#include "arena.h"
+#include <stddef.h>
+
+// The most ranges a worker's deque holds. A parallel for makes its ranges
+// larger rather than having more of them than the deques hold.
+#define JOB_SYSTEM_DEQUE_CAPACITY 64
+
+// Size of the arena each worker has for the transient allocations of a job.
+#define JOB_SYSTEM_SCRATCH_SIZE (16 * 1024)
+
+/*
+ * Does the work of a range of items, [first, last). Ranges run on any of the
+ * threads, in any order and concurrently, so a job must only write the items
+ * of its own range.
+ *
+ * @param scratch The worker's arena for the transient data of the range. It's
+ *                  reset before each parallel for.
+ */
+typedef void (*JobFunction)(void *data, size_t first, size_t last,
+                            Arena *scratch);
+
+typedef struct JobSystem JobSystem;
+
+/**
+ * @brief Creates a job system with a pool of worker threads.
+ *
+ * @param thread_count The amount of threads work runs on, the calling thread
+ *                          included, so 1 runs everything on it without any
+ *                          extra threads. If not positive, a thread per CPU.
+ * @return The created job system.
+ *
+ * @see job_system_destroy
+ */
+JobSystem *job_system_create(int thread_count);
+
+/**
+ * @brief Stops the worker threads and frees the job system.
+ */
+void job_system_destroy(JobSystem *jobs);
+
+/**
+ * @brief Gets the amount of threads work runs on, the calling thread included.
+ */
+int job_system_thread_count(const JobSystem *jobs);
+
+/**
+ * @brief Runs a job over the items [0, count), split into ranges of about
+ *          `grain` items, and returns once all of them are done.
+ *
+ * Each thread gets an even share of the ranges in its own deque, works
+ * through it from one end, and once it runs out steals ranges from the other
+ * end of the other deques, so a thread which got slower ranges doesn't hold
+ * the rest up. The calling thread works as one of the threads.
+ *
+ * @param count The amount of items.
+ * @param grain The amount of items in a range. Ranges are made larger if
+ *                  there would be more than the deques hold.
+ * @param function The job, called for each range.
+ * @param data Passed to the job.
+ */
+void job_system_parallel_for(JobSystem *jobs, size_t count, size_t grain,
+                             JobFunction function, void *data);
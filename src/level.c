@@ -1,36 +1,93 @@
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+
 #include "SDL.h"
+#include "arena.h"
 #include "csv.h"
-#include "dir.h"
 #include "level.h"
 #include "level_layer.h"
+#include "solid_bitmap.h"
 #include "tile.h"
 #include "tile_classes.h"
+#include "tile_grid.h"
 #include "tileset.h"
 #include "utils.h"
 #include "vec.h"
+#include "vfs.h"
 #include <errno.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 
-Level *level_create(char *name)
+Level *level_create(Arena *arena, InternedString name, size_t layer_capacity)
 {
-    Level *level = xmalloc(sizeof(*level));
+    Level *level = arena_alloc(arena, sizeof(*level));
 
-    level->layers = vector_create();
+    level->arena = arena;
     level->name = name;
+    level->trigger_grid = NULL;
+    level->collision_mesh = NULL;
+    level->solid_bitmap = NULL;
+    level->modified = false;
+    level->changed_area = (SDL_FRect){0};
+    level->layers = vector_create_in(arena);
+    // NOLINTNEXTLINE(bugprone-sizeof-expression)
+    vector_reserve(&level->layers, layer_capacity);
 
     return level;
 }
 
 void level_destroy(Level *level)
 {
-    for (size_t i = 0; i < vector_size(level->layers); i++)
+    // Everything but the modified tiles is in the arena.
+    level->modified = false; // The geometry is not needed anymore.
+    level_reset(level);
+    if (level->trigger_grid)
+        tile_grid_destroy(level->trigger_grid);
+    if (level->collision_mesh)
+        collision_mesh_destroy(level->collision_mesh);
+    if (level->solid_bitmap)
+        solid_bitmap_destroy(level->solid_bitmap);
+    arena_destroy(level->arena);
+}
+
+/**
+ * @brief Builds the solid bitmap again from the current tiles of the level.
+ */
+static void level_rebuild_solid_bitmap(Level *level)
+{
+    SDL_FPoint cell_size = level->solid_bitmap->cell_size;
+    solid_bitmap_destroy(level->solid_bitmap);
+    level->solid_bitmap = solid_bitmap_create(level->layers, cell_size);
+}
+
+/**
+ * @brief Builds the trigger grid and the collision mesh again from the current
+ *          tiles of the level.
+ */
+static void level_rebuild_geometry(Level *level)
+{
+    SDL_FPoint cell_size = level->solid_bitmap->cell_size;
+    tile_grid_destroy(level->trigger_grid);
+    level->trigger_grid =
+        tile_grid_create(level->layers, cell_size, tile_is_trigger);
+    collision_mesh_destroy(level->collision_mesh);
+    level->collision_mesh = collision_mesh_create(level->layers, cell_size);
+}
+
+void level_reset(Level *level)
+{
+    LevelLayer *layer;
+    vector_foreach(layer, level->layers)
+    {
+        level_layer_reset(layer);
+    }
+
+    if (level->modified)
     {
-        level_layer_destroy(level->layers[i]);
+        level_rebuild_geometry(level);
+        level_rebuild_solid_bitmap(level);
+        level->modified = false;
     }
-    vector_free(level->layers);
-    free(level->name);
-    free(level);
 }
 
 void level_draw(const Level *level, SDL_Renderer *renderer, SDL_FPoint *offset)
@@ -47,40 +104,110 @@ void level_add_layer(Level *level, LevelLayer *layer)
     vector_add(&level->layers, layer);
 }
 
-bool level_check_for_collision(Level *level, int target_id, SDL_FRect *hitbox)
+void level_set_tile(Level *level, size_t layer_index, size_t tile_index,
+                    Tile tile)
 {
-    LevelLayer *level_layer;
-    vector_foreach(level_layer, level->layers)
-    {
-        vector_iter(tile, level_layer->tiles)
-        {
-            if (tile->texture_id != target_id)
-                continue;
+    LevelLayer *layer = level->layers[layer_index];
+    Tile *level_tile = level_layer_get_tile_mut(layer, tile_index);
+    SDL_FRect previous_hitbox = level_tile->hitbox;
+    *level_tile = tile;
+    level->modified = true;
+    SDL_UnionFRect(&level->changed_area, &previous_hitbox,
+                   &level->changed_area);
+    SDL_UnionFRect(&level->changed_area, &tile.hitbox, &level->changed_area);
+
+    // The layer's metadata only grows, so it stays right after a reset.
+    SDL_UnionFRect(&layer->bounds, &tile.hitbox, &layer->bounds);
+    if (tile.solid)
+        layer->properties.flags |= LEVEL_LAYER_HAS_SOLID_TILES;
+
+    // Tiles change rarely, and merging the solid ones depends on their
+    // neighbours, so the mesh is built again. Only the bitmap is patched.
+    level_rebuild_geometry(level);
+    if (!solid_bitmap_refresh(level->solid_bitmap, level->layers,
+                              &previous_hitbox) ||
+        !solid_bitmap_refresh(level->solid_bitmap, level->layers,
+                              &tile.hitbox))
+        level_rebuild_solid_bitmap(level);
+}
 
-            if (SDL_HasIntersectionF(hitbox, &tile->hitbox))
-                return true;
-        }
-    }
+bool level_take_changed_area(Level *level, SDL_FRect *area)
+{
+    if (SDL_FRectEmpty(&level->changed_area))
+        return false;
+
+    *area = level->changed_area;
+    level->changed_area = (SDL_FRect){0};
 
-    return false;
+    return true;
+}
+
+bool level_check_for_collision(Level *level, int target_id, SDL_FRect *hitbox)
+{
+    return tile_grid_check_for_collision(level->trigger_grid, level->layers,
+                                         target_id, hitbox);
 }
 
 /**
- * @brief Returns the index of ch in the array
+ * @brief Counts the amount of times ch appears in the array.
  *
  * @param arr The array
  * @param size Array's size
- * @return The index of ch or `size` if ch is not in the array.
  */
-size_t index_of(char *arr, size_t size, char ch)
+size_t count_of(const char *arr, size_t size, char ch)
 {
+    size_t count = 0;
     for (size_t i = 0; i < size; i++)
     {
         if (arr[i] == ch)
-            return i;
+            count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Upper bound of the amount of csv fields (and so tiles) in a layer.
+ *          Every field but the last one is followed by a comma or a row end,
+ *          which the csv parser takes to be a new line, or a carriage return
+ *          on its own.
+ *
+ * @param layer_buf The csv of the layer.
+ * @param layer_size The size of the layer buffer.
+ */
+size_t level_layer_max_tiles(const char *layer_buf, size_t layer_size)
+{
+    size_t max_tiles = 1;
+    for (size_t i = 0; i < layer_size; i++)
+    {
+        bool is_lone_cr = layer_buf[i] == '\r' &&
+                          (i + 1 == layer_size || layer_buf[i + 1] != '\n');
+        if (layer_buf[i] == ',' || layer_buf[i] == '\n' || is_lone_cr)
+            max_tiles++;
     }
 
-    return size;
+    return max_tiles;
+}
+
+/**
+ * @brief Calculates the size of an arena which fits the whole level.
+ *
+ * @param layer_count The amount of layers in the level.
+ * @param max_tiles Upper bound of the amount of tiles in all the layers.
+ */
+size_t level_arena_size(size_t layer_count, size_t max_tiles)
+{
+    // Every vector is created empty and then reserved, and a reserved buffer
+    // might need up to ARENA_ALIGNMENT of padding.
+    return ARENA_ALIGN(sizeof(Level)) +
+           ARENA_ALIGN(vector_alloc_size(0, sizeof(LevelLayer *))) +
+           vector_alloc_size(layer_count, sizeof(LevelLayer *)) +
+           ARENA_ALIGNMENT +
+           layer_count * (ARENA_ALIGN(sizeof(LevelLayer)) +
+                          ARENA_ALIGN(vector_alloc_size(0, sizeof(Tile))) +
+                          vector_alloc_size(0, sizeof(Tile)) +
+                          ARENA_ALIGNMENT) +
+           max_tiles * sizeof(Tile);
 }
 
 struct LayerLoadingData
@@ -141,6 +268,119 @@ void level_row_parser_callback(int, void *data)
         layer_loading_data->tile_height * layer_loading_data->scaling_factor;
 }
 
+/**
+ * @brief Parses a `key=value` property from a layer's header.
+ *
+ * @param property The property, not null terminated.
+ * @param len The length of the property.
+ */
+static void level_layer_parse_property(const char *property, size_t len,
+                                       LevelLayerProperties *properties)
+{
+    char key[LEVEL_LAYER_PROPERTY_MAX];
+    if (len >= sizeof(key))
+        die("Error while loading level:\nLayer property too long: %.*s",
+            (int)len, property);
+    memcpy(key, property, len);
+    key[len] = '\0';
+
+    char *value = strchr(key, '=');
+    if (!value || !value[1])
+        die("Error while loading level:\nLayer property without a value: %s",
+            key);
+    *value++ = '\0';
+
+    char *value_end;
+    LevelLayerFlags flag = 0;
+    if (strcmp(key, "collidable") == 0)
+        flag = LEVEL_LAYER_COLLIDABLE;
+    else if (strcmp(key, "visible") == 0)
+        flag = LEVEL_LAYER_VISIBLE;
+
+    if (flag)
+    {
+        if (strtol(value, &value_end, 10))
+            properties->flags |= flag;
+        else
+            properties->flags &= ~flag;
+    }
+    else if (strcmp(key, "parallax") == 0)
+        properties->parallax = strtof(value, &value_end);
+    else if (strcmp(key, "z") == 0)
+        properties->z_order = strtol(value, &value_end, 10);
+    else
+        die("Error while loading level:\nUnknown layer property: %s", key);
+
+    if (*value_end)
+        die("Error while loading level:\nInvalid value of %s: %s", key,
+            value);
+}
+
+/**
+ * @brief Parses the header of a layer, if the layer starts with one.
+ *
+ * @param layer_buf The layer, up until layer_end.
+ * @param[out] properties Set to the properties in the header.
+ * @return Where the tiles of the layer start.
+ *
+ * @see level_load
+ */
+static const char *level_layer_parse_header(const char *layer_buf,
+                                            const char *layer_end,
+                                            LevelLayerProperties *properties)
+{
+    const char *header = layer_buf;
+    while (header < layer_end && SDL_isspace(*header))
+        header++;
+
+    if (header == layer_end || *header != LEVEL_LAYER_HEADER)
+        return layer_buf;
+
+    const char *header_end = memchr(header, '\n', layer_end - header);
+    if (!header_end)
+        header_end = layer_end;
+
+    const char *property = header + 1;
+    while (true)
+    {
+        while (property < header_end && SDL_isspace(*property))
+            property++;
+        if (property == header_end)
+            break;
+
+        const char *property_end = property;
+        while (property_end < header_end && !SDL_isspace(*property_end))
+            property_end++;
+
+        level_layer_parse_property(property, property_end - property,
+                                   properties);
+        property = property_end;
+    }
+
+    return header_end;
+}
+
+/**
+ * @brief Orders the layers by their z order, keeping the order of the file
+ *          between equal ones.
+ */
+static void level_sort_layers(Level *level)
+{
+    VecLevelLayer layers = level->layers;
+    for (size_t i = 1; i < vector_size(layers); i++)
+    {
+        LevelLayer *layer = layers[i];
+        size_t j = i;
+        for (; j > 0 &&
+               layers[j - 1]->properties.z_order > layer->properties.z_order;
+             j--)
+        {
+            layers[j] = layers[j - 1];
+        }
+        layers[j] = layer;
+    }
+}
+
 Level *level_load(FILE *stream, const Tileset *tileset, int tile_width,
                   int tile_height, int scaling_factor)
 {
@@ -152,89 +392,128 @@ Level *level_load(FILE *stream, const Tileset *tileset, int tile_width,
         return NULL;
     }
 
-    char *level_name = readline(stream, '\n', 0, 0);
-    Level *level = level_create(level_name);
+    /* The whole file is read first, so the level's arena can be sized with
+     * a pass over it, and the level is then loaded without any reallocs. */
+    size_t size = 0;
+    char *buf = read_stream(stream, &size);
+    const char *buf_end = buf + size;
+
+    const char *level_name_end = memchr(buf, '\n', size);
+    if (!level_name_end)
+        level_name_end = buf_end;
+    InternedString level_name = intern(buf, level_name_end - buf);
+
+    const char *layers_buf = SDL_min(level_name_end + 1, buf_end);
+    size_t layers_size = buf_end - layers_buf;
+    size_t layer_count =
+        count_of(layers_buf, layers_size, LEVEL_LAYER_SEPARATOR) + 1;
+
+    // Each layer is bounded separately, which adds one tile per layer.
+    size_t max_tiles =
+        level_layer_max_tiles(layers_buf, layers_size) + layer_count;
+
+    Arena *arena = arena_create_tagged(
+        ALLOC_TAG_LEVEL, level_arena_size(layer_count, max_tiles));
+    Level *level = level_create(arena, level_name, layer_count);
 
     struct LayerLoadingData layer_loading_data = {
         .tile_width = tile_width,
         .tile_height = tile_height,
         .tileset = tileset,
         .scaling_factor = scaling_factor,
-        .current_pos = (SDL_Point){0},
-        .current_layer = level_layer_create()};
-
-    char buf[1024] = {0};
-    size_t bytes_read = 0;
-    while ((bytes_read = fread(buf, 1, sizeof(buf), stream)) > 0)
+    };
+
+    /*
+     * Note about the following algorithm: We do not care if layer separator
+     * comes with a new line, as csv_parse ignores empty lines by default.
+     *
+     * Each layer is parsed up until the separator (or the end of the file),
+     * and the next layer starts right after the separator.
+     */
+    const char *layer_buf = layers_buf;
+    for (int layer_index = 0;; layer_index++)
     {
-        char *layer_buf = buf;
-        size_t layer_size = 0;
-        /*
-         * Note about the following algorithm: We do not care if layer separator
-         * comes with a new line, as csv_parse ignores empty lines by default.
-         *
-         * The algo works by just reading until the sep, and moving the layer
-         * buffer to start right after the sep. And we read like this until we
-         * have read the whole buf.
-         */
-        do
+        const char *layer_end =
+            memchr(layer_buf, LEVEL_LAYER_SEPARATOR, buf_end - layer_buf);
+        if (!layer_end)
+            layer_end = buf_end;
+
+        LevelLayerProperties properties = {
+            .flags = LEVEL_LAYER_COLLIDABLE | LEVEL_LAYER_VISIBLE,
+            .parallax = 1,
+            .z_order = layer_index,
+        };
+        layer_buf = level_layer_parse_header(layer_buf, layer_end, &properties);
+        size_t layer_size = layer_end - layer_buf;
+
+        layer_loading_data.current_layer = level_layer_create(
+            arena, level_layer_max_tiles(layer_buf, layer_size));
+        layer_loading_data.current_layer->properties = properties;
+        layer_loading_data.current_pos = (SDL_Point){0};
+
+        if (csv_parse(&parser, layer_buf, layer_size,
+                      level_field_parser_callback, level_row_parser_callback,
+                      &layer_loading_data) != layer_size)
         {
-            size_t prev_layer_size = layer_size;
-
-            layer_buf += prev_layer_size;
-            layer_size = index_of(layer_buf, bytes_read - prev_layer_size,
-                                  LEVEL_LAYER_SEPARATOR);
-
-            if (csv_parse(&parser, layer_buf, layer_size,
-                          level_field_parser_callback,
-                          level_row_parser_callback,
-                          &layer_loading_data) != layer_size)
-            {
-                SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
-                                         "Error during level parsing",
-                                         csv_strerror(csv_error(&parser)), 0);
-            }
-
-            bool there_will_be_a_new_layer =
-                layer_size != bytes_read - prev_layer_size;
-            if (there_will_be_a_new_layer)
-            {
-                level_add_layer(level, layer_loading_data.current_layer);
-                layer_loading_data.current_layer = level_layer_create();
-                layer_loading_data.current_pos = (SDL_Point){0};
-                layer_size += 1; // Skip the separator.
-            }
-
-        } while (layer_buf + layer_size != buf + bytes_read);
+            SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,
+                                     "Error during level parsing",
+                                     csv_strerror(csv_error(&parser)), 0);
+        }
+
+        // Finish the last row of the layer.
+        csv_fini(&parser, level_field_parser_callback,
+                 level_row_parser_callback, &layer_loading_data);
+
+        level_add_layer(level, layer_loading_data.current_layer);
+
+        if (layer_end == buf_end)
+            break;
+
+        layer_buf = layer_end + 1; // Skip the separator.
     }
 
-    csv_fini(&parser, level_field_parser_callback, level_row_parser_callback,
-             &layer_loading_data);
     csv_free(&parser);
+    free(buf);
+
+    // The layers are indexed once sorted, so they can be drawn in order.
+    level_sort_layers(level);
 
-    level_add_layer(level, layer_loading_data.current_layer);
+    SDL_FPoint cell_size = {tile_width * scaling_factor,
+                            tile_height * scaling_factor};
+    level->trigger_grid =
+        tile_grid_create(level->layers, cell_size, tile_is_trigger);
+    level->collision_mesh = collision_mesh_create(level->layers, cell_size);
+    level->solid_bitmap = solid_bitmap_create(level->layers, cell_size);
 
     return level;
 }
 
 void level_select(Level **current_level_ptr, LevelHashmap *levels,
-                  const char *level_name, SDL_FRect *character_hitbox_ptr)
+                  InternedString level_name, SDL_FPoint *character_pos_ptr)
 {
     SDL_assert(current_level_ptr != NULL); // Not that others arguments can be
                                            // NULL, but this one I think is the
                                            // most confusing out of them all.
 
-    if (*current_level_ptr)
-        level_destroy(*current_level_ptr);
-
-    *current_level_ptr = hashmap_remove(levels, level_name);
+    *current_level_ptr = hashmap_get(levels, level_name);
 
     Level *level = *current_level_ptr;
+    if (!level)
+        return;
+
+    level_reset(level);
+
+    // Everything in the level is new to the bodies.
+    LevelLayer *layer;
+    vector_foreach(layer, level->layers)
+    {
+        SDL_UnionFRect(&level->changed_area, &layer->bounds,
+                       &level->changed_area);
+    }
 
     /* We set player's position to the position of the first lowest tile with
      * the class id of SPAWN_POINT */
     float lowest_y_so_far = -INFINITY;
-    LevelLayer *layer;
     vector_foreach(layer, level->layers)
     {
         vector_iter(tile, layer->tiles)
@@ -246,89 +525,63 @@ void level_select(Level **current_level_ptr, LevelHashmap *levels,
                 continue;
 
             lowest_y_so_far = tile->hitbox.y;
-            character_hitbox_ptr->x = tile->hitbox.x;
-            character_hitbox_ptr->y = tile->hitbox.y;
+            character_pos_ptr->x = tile->hitbox.x;
+            character_pos_ptr->y = tile->hitbox.y;
         }
     }
 
     if (lowest_y_so_far == -INFINITY)
     {
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
-                    "No spawn point found on level %s", level_name);
+                    "No spawn point found on level %s", level_name->str);
     }
 }
 
-typedef const char *vec_const_char;
-typedef vec_const_char *vec_const_str;
-
-LevelHashmap *levels_load_from_dirs(const char *levels_dir_path,
+LevelHashmap *levels_load_from_dirs(const Vfs *vfs,
+                                    const char *levels_dir_path,
                                     Tileset *tileset, int tile_width,
                                     int tile_height, int scaling_factor)
 {
-    vec_const_str level_paths = vector_create();
+    VecPath level_paths = vector_create();
 
-    DIR *levels_dir = opendir(levels_dir_path);
-    if (!levels_dir)
+    VecPath level_dir_paths = vfs_list_dir(vfs, levels_dir_path);
+    if (!level_dir_paths)
         die("Opening directory %s failed", levels_dir_path);
 
-    struct dirent *levels_dir_entry;
-    while ((levels_dir_entry = readdir(levels_dir)))
+    char *level_dir_path;
+    vector_foreach(level_dir_path, level_dir_paths)
     {
-        if (strcmp(levels_dir_entry->d_name, ".") == 0 ||
-            strcmp(levels_dir_entry->d_name, "..") == 0)
-            continue;
-
-        char *level_dir_path =
-            dir_get_path_to_entry(levels_dir_entry, levels_dir_path);
-
-        DIR *level_dir = opendir(level_dir_path);
-        if (!level_dir)
+        VecPath level_dir_entries = vfs_list_dir(vfs, level_dir_path);
+        if (!level_dir_entries)
             die("Opening directory %s failed", level_dir_path);
 
-        struct dirent *level_dir_entry;
-        while ((level_dir_entry = readdir(level_dir)))
-        {
-            if (strcmp(level_dir_entry->d_name, ".") == 0 ||
-                strcmp(level_dir_entry->d_name, "..") == 0)
-                continue;
-
-            const char *level_path =
-                dir_get_path_to_entry(level_dir_entry, level_dir_path);
-
-            vector_add(&level_paths, level_path);
-        }
+        vector_concat(&level_paths, level_dir_entries);
 
-        free(level_dir_path);
-        closedir(level_dir);
+        // The paths were moved to level_paths.
+        vector_free(level_dir_entries);
     }
 
-    closedir(levels_dir);
+    vfs_free_paths(level_dir_paths);
 
     LevelHashmap *levels =
-        levels_load(level_paths, vector_size(level_paths), tileset, tile_width,
-                    tile_height, scaling_factor);
-
-    const char *path;
-    vector_foreach(path, level_paths)
-    {
-        free((char *)path);
-    }
+        levels_load(vfs, (const char **)level_paths, vector_size(level_paths),
+                    tileset, tile_width, tile_height, scaling_factor);
 
-    vector_free(level_paths);
+    vfs_free_paths(level_paths);
 
     return levels;
 }
 
-LevelHashmap *levels_load(const char **level_paths, size_t size,
-                          Tileset *tileset, int tile_width, int tile_height,
-                          int scaling_factor)
+LevelHashmap *levels_load(const Vfs *vfs, const char **level_paths,
+                          size_t size, Tileset *tileset, int tile_width,
+                          int tile_height, int scaling_factor)
 {
     LevelHashmap *levels = malloc(sizeof(*levels));
-    hashmap_init(levels, hashmap_hash_string, strcmp);
+    hashmap_init(levels, interned_string_hash, interned_string_compare);
 
     for (size_t i = 0; i < size; i++)
     {
-        FILE *file = fopen(level_paths[i], "rb");
+        FILE *file = vfs_fopen(vfs, level_paths[i]);
 
         if (!file)
             die("Opening file %s failed", level_paths[i]);
@@ -343,7 +596,7 @@ LevelHashmap *levels_load(const char **level_paths, size_t size,
         if (err == -EEXIST)
             die("Names of levels should be unique, but %s appeared more than "
                 "once",
-                level->name);
+                level->name->str);
         else if (err)
             die("Error while loading level %s - %s", level, strerror(-err));
     }
@@ -353,7 +606,7 @@ LevelHashmap *levels_load(const char **level_paths, size_t size,
 
 void levels_unload(LevelHashmap *levels)
 {
-    const char *key;
+    const HashedString *key;
     void *temp;
 
     hashmap_foreach_key_safe(key, levels, temp)
@@ -1,43 +1,97 @@
 #pragma once
 
 #include "SDL.h"
+#include "arena.h"
+#include "collision_mesh.h"
 #include "hashmap.h"
+#include "intern.h"
 #include "level_layer.h"
+#include "solid_bitmap.h"
+#include "tile_grid.h"
 #include "tileset.h"
+#include "vfs.h"
 
 #define LEVEL_LAYER_SEPARATOR '\\'
+// Starts the optional header line of a layer, with the layer's properties.
+#define LEVEL_LAYER_HEADER '#'
+// The longest `key=value` property in a layer's header.
+#define LEVEL_LAYER_PROPERTY_MAX 64
 
 typedef struct Level
 {
-    char *name;
+    InternedString name;
     VecLevelLayer layers;
+    Arena *arena; // Holds the level itself and all of its data.
+    // The trigger tiles, the solid tiles and the solid cells, all of which
+    // follow tile changes.
+    TileGrid *trigger_grid;
+    CollisionMesh *collision_mesh;
+    SolidBitmap *solid_bitmap;
+    bool modified; // Whether a tile was changed during the current visit.
+    SDL_FRect changed_area; // Bounds what changed since it was last taken.
 } Level;
 
-HASHMAP_NAMED_TYPEDEF(LevelHashmap, char, Level)
+HASHMAP_NAMED_TYPEDEF(LevelHashmap, HashedString, Level)
 
 /**
- * @brief Creates a level.
+ * @brief Creates a level in an arena.
  *
- * @param name The name of the level. Managed by the level.
- * @warning The name will be freed by the destructor.
+ * @param arena The arena to allocate the level from. Managed by the level.
+ * @warning The arena will be destroyed by the destructor.
+ * @param name The name of the level.
+ * @param layer_capacity The amount of layers the level can hold without
+ *                          growing.
  * @return The created level.
  */
-Level *level_create(char *name);
+Level *level_create(Arena *arena, InternedString name, size_t layer_capacity);
 
 /**
- * @brief Destroys the level.
+ * @brief Destroys the level, along with its arena, its grid, its collision
+ *          mesh and its bitmap.
  *
  * @param level The level to destroy.
  */
 void level_destroy(Level *level);
 
+/**
+ * @brief Discards all the changes made to the level during the current visit,
+ *          and builds its geometry again if there were any.
+ *
+ * @see level_layer_reset
+ */
+void level_reset(Level *level);
+
 /**
  * @brief Adds a layer to the level.
  *
- * @param layer The layer to add.
+ * @param layer The layer to add. Must be allocated from the level's arena.
  */
 void level_add_layer(Level *level, LevelLayer *layer);
 
+/**
+ * @brief Replaces a tile of the level for the rest of the current visit, and
+ *          updates the level's trigger grid, collision mesh and solid bitmap
+ *          accordingly.
+ *
+ * @param layer_index The index of the tile's layer.
+ * @param tile_index The index of the tile in the layer.
+ * @param tile The new tile.
+ *
+ * @see level_layer_get_tile_mut
+ */
+void level_set_tile(Level *level, size_t layer_index, size_t tile_index,
+                    Tile tile);
+
+/**
+ * @brief Takes the area where the level changed since it was last taken, the
+ *          tiles replaced by level_set_tile, or the whole level once it's
+ *          selected, so what was in it can be woken.
+ *
+ * @param[out] area The area which changed.
+ * @return Whether anything changed.
+ */
+bool level_take_changed_area(Level *level, SDL_FRect *area);
+
 /**
  * @brief Draws the level.
  *
@@ -52,7 +106,13 @@ void level_draw(const Level *level, SDL_Renderer *renderer, SDL_FPoint *offset);
  * @brief Loads a level from a file.
  *
  * @param stream The stream to load level from. First line is expected to be
- *                  the name of the level.
+ *                  the name of the level. Each layer may start with a header
+ *                  line of space separated properties, e.g.
+ *                  `# collidable=0 visible=1 parallax=0.5 z=-1`. A layer
+ *                  defaults to collidable, visible, a parallax of 1 and a z
+ *                  order of its index in the file. A layer with another
+ *                  parallax is never collided with, and its triggers never
+ *                  fire.
  * @param tileset The tileset to use for the textures.
  * @param tile_width The width of a tile in the level (before scaling).
  * @param tile_height The height of a tile in the level (before scaling).
@@ -66,29 +126,27 @@ Level *level_load(FILE *stream, const Tileset *tileset, int tile_width,
  * @brief Selects a level from a level hashmap based on its name and sets
  *          character's position to the spawn point of the selected level.
  *
- * @warning The selected level will be removed from the hashmap (levels).
- * @warning The current level (*current_level_ptr) will be destroyed if
- *              (*current_level_ptr) is not NULL.
+ * The levels stay in the hashmap, so any level can be selected again later
+ * without reloading it. Every visit starts with the level as it was loaded.
  *
- * @param current_level_ptr Pointer to the current level. The current one will
- *                              be destroyed if it's not NULL and then will be
- *                              replaced with the new level.
+ * @param current_level_ptr Pointer to the current level. Will be replaced with
+ *                              the selected level, or NULL if there is no
+ *                              level with the given name.
  * @param levels Hashmap of Levels where the level to select is stored.
- *                  The selected level will be removed from it.
  * @param level_name The name of the level to select.
- * @param[out] character_hitbox_ptr Pointer to character's hitbox. The x
- *                                      and y of the hitbox will be changed to
- *                                      match the position of the spawn point
- *                                      on the selected level.
+ * @param[out] character_pos_ptr Pointer to character's position. It will be
+ *                                  changed to match the position of the spawn
+ *                                  point on the selected level.
  *
- * @see level_destroy
+ * @see level_reset
  */
 void level_select(Level **current_level_ptr, LevelHashmap *levels,
-                  const char *level_name, SDL_FRect *character_hitbox_ptr);
+                  InternedString level_name, SDL_FPoint *character_pos_ptr);
 
 /**
  * @brief Loads the levels stored in the given file paths using the given tileset.
  *
+ * @param vfs The file system to read the levels from.
  * @param level_paths Paths to files with the level data.
  * @see level_load
  * @param size The size of the level_paths array.
@@ -100,9 +158,9 @@ void level_select(Level **current_level_ptr, LevelHashmap *levels,
  *
  * @see levels_unload
  */
-LevelHashmap *levels_load(const char **level_paths, size_t size,
-                          Tileset *tileset, int tile_width, int tile_height,
-                          int scaling_factor);
+LevelHashmap *levels_load(const Vfs *vfs, const char **level_paths,
+                          size_t size, Tileset *tileset, int tile_width,
+                          int tile_height, int scaling_factor);
 
 /**
  * @brief Same as levels load, but instead of level paths, gets dir path, and finds the levels inside.
@@ -116,6 +174,7 @@ LevelHashmap *levels_load(const char **level_paths, size_t size,
  *              - - ...
  *              - ...
  *
+ * @param vfs The file system to read the levels from.
  * @param levels_dir_path Path to the directory with the levels.
  * @param tileset The tileset to use.
  * @param tile_width The width of a tile in the level (before scaling).
@@ -126,7 +185,8 @@ LevelHashmap *levels_load(const char **level_paths, size_t size,
  * @see levels_unload
  * @see levels_load
  */
-LevelHashmap *levels_load_from_dirs(const char *levels_dir_path,
+LevelHashmap *levels_load_from_dirs(const Vfs *vfs,
+                                    const char *levels_dir_path,
                                     Tileset *tileset, int tile_width,
                                     int tile_height, int scaling_factor);
 
@@ -142,7 +202,8 @@ void levels_unload(LevelHashmap *levels);
 
 /**
  * @brief Checks for collision between all the tiles in the level with the given
- *          id (target_id) and the given hitbox.
+ *          id (target_id) and the given hitbox. Only the trigger tiles (the
+ *          ones with a callback) near the hitbox are checked.
  *
  * @param level The level to check for collision in.
  * @param target_id The id of the tile to check for collision.
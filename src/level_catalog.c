@@ -0,0 +1,71 @@
+#include "SDL.h"
+#include "level.h"
+#include "level_catalog.h"
+#include "rng.h"
+#include "utils.h"
+#include "vec.h"
+
+LevelCatalog *level_catalog_create(LevelHashmap *levels)
+{
+    LevelCatalog *catalog = xmalloc(sizeof(*catalog));
+    catalog->levels =
+        vector_create_with_capacity(Level *, hashmap_size(levels));
+
+    Level *level;
+    hashmap_foreach_data(level, levels)
+    {
+        // NOLINTNEXTLINE(bugprone-sizeof-expression)
+        vector_add(&catalog->levels, level);
+    }
+
+    return catalog;
+}
+
+void level_catalog_destroy(LevelCatalog *catalog)
+{
+    vector_free(catalog->levels);
+    free(catalog);
+}
+
+/**
+ * @brief Swaps two slots of the catalog.
+ */
+static void level_catalog_swap(LevelCatalog *catalog, size_t a, size_t b)
+{
+    Level *temp = catalog->levels[a];
+    catalog->levels[a] = catalog->levels[b];
+    catalog->levels[b] = temp;
+}
+
+void level_catalog_set_current(LevelCatalog *catalog, const Level *level)
+{
+    size_t last = vector_size(catalog->levels) - 1;
+    for (size_t i = 0; i < vector_size(catalog->levels); i++)
+    {
+        if (catalog->levels[i] == level)
+        {
+            level_catalog_swap(catalog, i, last);
+            return;
+        }
+    }
+
+    SDL_assert(!"The level is not in the catalog");
+}
+
+Level *level_catalog_pick_other(LevelCatalog *catalog,
+                                const Level *current_level, Rng *rng)
+{
+    size_t size = vector_size(catalog->levels);
+    if (size < 2)
+        return NULL;
+
+    if (catalog->levels[size - 1] != current_level)
+        level_catalog_set_current(catalog, current_level);
+
+    // The picked level takes the last slot, and the previous current level
+    // takes the picked one's.
+    size_t picked = rng_below(rng, size - 1);
+    level_catalog_swap(catalog, picked, size - 1);
+
+    return catalog->levels[size - 1];
+}
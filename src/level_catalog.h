@@ -0,0 +1,51 @@
+#pragma once
+
+#include "level.h"
+#include "rng.h"
+
+typedef Level **VecLevel;
+
+/*
+ * A dense array of the loaded levels, for picking levels at random. The
+ * current level is kept in the last slot, so the other levels are the slots
+ * before it, and picking one of them is a single draw and a swap.
+ */
+typedef struct LevelCatalog
+{
+    VecLevel levels;
+} LevelCatalog;
+
+/**
+ * @brief Creates a catalog of the levels in the hashmap. No level is current.
+ *
+ * @param levels The levels, which must outlive the catalog.
+ * @return The created catalog.
+ *
+ * @see level_catalog_destroy
+ */
+LevelCatalog *level_catalog_create(LevelHashmap *levels);
+
+/**
+ * @brief Destroys the catalog, without the levels.
+ */
+void level_catalog_destroy(LevelCatalog *catalog);
+
+/**
+ * @brief Sets the current level of the catalog, the level which won't be
+ *          picked. Linear in the amount of levels.
+ *
+ * @param level The current level, must be in the catalog.
+ */
+void level_catalog_set_current(LevelCatalog *catalog, const Level *level);
+
+/**
+ * @brief Picks a random level other than the current one, which becomes the
+ *          current level of the catalog.
+ *
+ * @param current_level The current level. If the catalog has another level
+ *                          as current, it's set first.
+ * @param rng The generator to draw from.
+ * @return The picked level, or NULL if there is no other level.
+ */
+Level *level_catalog_pick_other(LevelCatalog *catalog,
+                                const Level *current_level, Rng *rng);
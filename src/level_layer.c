@@ -1,33 +1,97 @@
 #include "SDL.h"
+#include "arena.h"
 #include "level_layer.h"
-#include "utils.h"
 #include "vec.h"
 
-LevelLayer *level_layer_create(void)
+LevelLayer *level_layer_create(Arena *arena, size_t tile_capacity)
 {
-    LevelLayer *layer = xmalloc(sizeof(*layer));
+    LevelLayer *layer = arena_alloc(arena, sizeof(*layer));
 
-    layer->tiles = vector_create();
+    layer->base_tiles = vector_create_in(arena);
+    vector_reserve(&layer->base_tiles, tile_capacity);
+    layer->tiles = layer->base_tiles;
+    layer->properties = (LevelLayerProperties){
+        .flags = LEVEL_LAYER_COLLIDABLE | LEVEL_LAYER_VISIBLE,
+        .parallax = 1,
+    };
+    layer->bounds = (SDL_FRect){0};
 
     return layer;
 }
 
-void level_layer_destroy(LevelLayer *layer)
+size_t level_layer_arena_size(size_t tile_capacity)
 {
-    vector_free(layer->tiles);
-    free(layer);
+    // The tiles are reserved after the vector is created, so the reserved
+    // buffer might need up to ARENA_ALIGNMENT of padding.
+    return ARENA_ALIGN(sizeof(LevelLayer)) +
+           ARENA_ALIGN(vector_alloc_size(0, sizeof(Tile))) +
+           vector_alloc_size(tile_capacity, sizeof(Tile)) + ARENA_ALIGNMENT;
 }
 
 void level_layer_add_tile(LevelLayer *layer, Tile tile)
 {
-    vector_add(&layer->tiles, tile);
+    SDL_assert(layer->tiles == layer->base_tiles &&
+               "Tiles can't be added after the layer was modified");
+
+    vector_push_unchecked(&layer->base_tiles, tile);
+    layer->tiles = layer->base_tiles;
+
+    SDL_UnionFRect(&layer->bounds, &tile.hitbox, &layer->bounds);
+    if (tile.solid)
+        layer->properties.flags |= LEVEL_LAYER_HAS_SOLID_TILES;
+}
+
+Tile *level_layer_get_tile_mut(LevelLayer *layer, size_t index)
+{
+    if (layer->tiles == layer->base_tiles)
+        layer->tiles = vector_copy(layer->base_tiles);
+
+    return &layer->tiles[index];
+}
+
+void level_layer_reset(LevelLayer *layer)
+{
+    if (layer->tiles == layer->base_tiles)
+        return;
+
+    vector_free(layer->tiles);
+    layer->tiles = layer->base_tiles;
+}
+
+bool level_layer_is_collidable(const LevelLayer *layer)
+{
+    // A parallax layer is drawn away from its tiles, so what is seen of it
+    // wouldn't be what is collided with.
+    LevelLayerFlags collidable =
+        LEVEL_LAYER_COLLIDABLE | LEVEL_LAYER_HAS_SOLID_TILES;
+    return (layer->properties.flags & collidable) == collidable &&
+           layer->properties.parallax == 1;
 }
 
 void level_layer_draw(const LevelLayer *layer, SDL_Renderer *renderer,
                       SDL_FPoint *offset)
 {
+    if (!(layer->properties.flags & LEVEL_LAYER_VISIBLE))
+        return;
+
+    SDL_FPoint layer_offset = {0};
+    if (offset)
+    {
+        layer_offset.x = offset->x * layer->properties.parallax;
+        layer_offset.y = offset->y * layer->properties.parallax;
+    }
+
+    SDL_Rect viewport;
+    SDL_RenderGetViewport(renderer, &viewport);
+    SDL_FRect screen = {0, 0, viewport.w, viewport.h};
+    SDL_FRect bounds = layer->bounds;
+    bounds.x += layer_offset.x;
+    bounds.y += layer_offset.y;
+    if (!SDL_HasIntersectionF(&bounds, &screen))
+        return;
+
     for (size_t i = 0; i < vector_size(layer->tiles); i++)
     {
-        tile_draw(&layer->tiles[i], renderer, offset);
+        tile_draw(&layer->tiles[i], renderer, &layer_offset);
     }
 }
@@ -1,40 +1,96 @@
 #pragma once
 
 #include "SDL.h"
+#include "arena.h"
 #include "tile.h"
 #include "vec.h"
 
+typedef Uint8 LevelLayerFlags;
+// Physics collides with the solid tiles of the layer (declared).
+#define LEVEL_LAYER_COLLIDABLE (LevelLayerFlags)0x01
+// The layer is drawn (declared).
+#define LEVEL_LAYER_VISIBLE (LevelLayerFlags)0x02
+// The layer has solid tiles (inferred from the tiles).
+#define LEVEL_LAYER_HAS_SOLID_TILES (LevelLayerFlags)0x04
+
+typedef struct LevelLayerProperties
+{
+    LevelLayerFlags flags;
+    float parallax; // How much the layer moves with the camera, 1 for fully.
+    int z_order;    // The layers are drawn from the lowest z order up.
+} LevelLayerProperties;
+
 typedef struct LevelLayer
 {
-    VecTile tiles;
+    VecTile tiles; /* The tiles of the current visit of the level.
+                    * Do not modify directly, use level_layer_get_tile_mut. */
+
+    /* private: The tiles as they were loaded. `tiles` points to them until
+     * a tile is modified (copy on write). */
+    VecTile base_tiles;
+
+    LevelLayerProperties properties;
+    SDL_FRect bounds; // Bounds all the tiles the layer has had.
 } LevelLayer;
 
 typedef LevelLayer **VecLevelLayer;
 
 /**
- * @brief Creates a level layer.
+ * @brief Creates a level layer in an arena.
  *
- * @return The created level layer.
+ * @param arena The arena to allocate the layer and its tiles from.
+ * @param tile_capacity The amount of tiles the layer can hold. No more than
+ *                      this many tiles can be added.
+ * @return The created level layer, collidable and visible, with a parallax
+ *          of 1. Freed with the arena, after level_layer_reset is called.
  */
-LevelLayer *level_layer_create(void);
+LevelLayer *level_layer_create(Arena *arena, size_t tile_capacity);
 
 /**
- * @brief Destroys the level layer.
+ * @brief Calculates the amount of arena memory a level layer takes.
+ *
+ * @param tile_capacity The amount of tiles the layer can hold.
  */
-void level_layer_destroy(LevelLayer *layer);
+size_t level_layer_arena_size(size_t tile_capacity);
 
 /**
- * @brief Adds a tile to the level layer.
+ * @brief Adds a tile to the level layer. Used while loading the layer, the
+ *          layer's tile capacity must not be exceeded.
  *
  * @param tile The tile to add.
  */
 void level_layer_add_tile(LevelLayer *layer, Tile tile);
 
 /**
- * @brief Draws the level layer.
+ * @brief Gets a tile for modification. The first modification during a visit
+ *          copies the tiles of the layer, so the loaded tiles stay untouched.
+ *
+ * @param index The index of the tile in `layer->tiles`.
+ * @return Pointer to the tile, valid until the layer is reset.
+ *
+ * @see level_layer_reset
+ */
+Tile *level_layer_get_tile_mut(LevelLayer *layer, size_t index);
+
+/**
+ * @brief Discards all the modifications made to the tiles, returning the layer
+ *          to the state it was loaded in.
+ */
+void level_layer_reset(LevelLayer *layer);
+
+/**
+ * @brief Checks if physics has to consider the layer: it is collidable, has
+ *          solid tiles, and has a parallax of 1, so it's drawn where its
+ *          tiles are.
+ */
+bool level_layer_is_collidable(const LevelLayer *layer);
+
+/**
+ * @brief Draws the level layer, unless it is invisible or off screen.
  *
  * @param renderer The renderer to draw onto.
- * @param offset The offset to apply to each of the tiles.
+ * @param offset The offset of the camera, applied to each of the tiles
+ *                  scaled by the layer's parallax.
  *
  * @see tile_draw
  */
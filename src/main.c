@@ -1,53 +1,118 @@
 #include "SDL.h"
-#include "SDL_image.h"
+#include "alloc_stats.h"
+#include "arena.h"
 #include "character.h"
-#include "dir.h"
+#include "frame_profiler.h"
 #include "hashmap.h"
+#include "input_replay.h"
+#include "intern.h"
+#include "job_system.h"
 #include "level.h"
+#include "level_catalog.h"
 #include "main.h"
+#include "physics_world.h"
 #include "renderer.h"
+#include "rng.h"
 #include "tile_keyboard_events.h"
+#include "tile_overlaps.h"
 #include "utils.h"
+#include "vfs.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <unistd.h>
 
 int main(int argc, char *argv[])
 {
-    if (argc < 5)
+    const char *pack_path = NULL;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *frame_times_path = NULL;
+    uint64_t seed = time(NULL);
+
+    int option;
+    while ((option = getopt(argc, argv, "p:s:r:R:t:")) != -1)
     {
-        die("Usage: %s <Character Texture Path> <Tileset Path> <Textures path> "
-            "<KeyMap path> <Starting level name> <Level dir path>",
-            argv[0]);
+        switch (option)
+        {
+            case 'p':
+                pack_path = optarg;
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'r':
+                record_path = optarg;
+                break;
+            case 'R':
+                replay_path = optarg;
+                break;
+            case 't':
+                frame_times_path = optarg;
+                break;
+            default:
+                die(USAGE, argv[0]);
+        }
     }
-    srand(time(NULL));
 
-    const char *character_texture_path = argv[1];
-    const char *tileset_path = argv[2];
-    const char *textures_dir_path = argv[3];
-    const char *keymap_path = argv[4];
-    const char *starting_level_name = argv[5];
-    const char *levels_dir_path = argv[6];
+    if (argc - optind < 6)
+        die(USAGE, argv[0]);
+
+    InputPlayer *input_player = NULL;
+    if (replay_path)
+    {
+        input_player = input_player_open(replay_path);
+        if (!input_player)
+            die("Loading recording %s failed", replay_path);
+
+        // The run is only the same with the recorded seed.
+        seed = input_player->seed;
+    }
+
+    InputRecorder *input_recorder = NULL;
+    if (record_path)
+    {
+        input_recorder = input_recorder_open(record_path, seed);
+        if (!input_recorder)
+            die("Opening %s failed: %s", record_path, strerror(errno));
+    }
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    SDL_Log("Random seed: %" SDL_PRIu64, seed);
+
+    const char *character_texture_path = argv[optind];
+    const char *tileset_path = argv[optind + 1];
+    const char *textures_dir_path = argv[optind + 2];
+    const char *keymap_path = argv[optind + 3];
+    InternedString starting_level_name = intern_cstr(argv[optind + 4]);
+    const char *levels_dir_path = argv[optind + 5];
+
+    Vfs *vfs = vfs_create(pack_path);
+    if (!vfs)
+        die("Opening asset pack %s failed: %s", pack_path, strerror(errno));
 
     SDL_Window *window = NULL;
     SDL_Renderer *renderer = NULL;
 
-    init_sdl(&window, &renderer);
+    // Recordings are played back headless, as fast as possible.
+    init_sdl(&window, &renderer, input_player != NULL);
 
-    FILE *tileset_file = fopen(tileset_path, "rb");
+    FILE *tileset_file = vfs_fopen(vfs, tileset_path);
 
     if (!tileset_file)
         die("Opening file %s failed", tileset_path);
 
     Tileset *tileset =
-        tileset_load(tileset_file, strdup(textures_dir_path), renderer);
+        tileset_load(vfs, tileset_file, strdup(textures_dir_path), renderer);
 
     fclose(tileset_file);
 
     if (!tileset)
         die("Loading tileset %s failed", tileset_path);
 
-    FILE *keymap_file = fopen(keymap_path, "rb");
+    FILE *keymap_file = vfs_fopen(vfs, keymap_path);
 
     if (!keymap_file)
         die("Opening file %s failed", keymap_path);
@@ -61,43 +126,59 @@ int main(int argc, char *argv[])
         die("Loading keymap %s failed", keymap_path);
 
     SDL_Texture *character_texture =
-        IMG_LoadTexture(renderer, character_texture_path);
+        vfs_load_texture(vfs, renderer, character_texture_path);
     if (!character_texture)
         die("Loading %s failed", character_texture_path);
 
     int w, h;
     SDL_QueryTexture(character_texture, NULL, NULL, &w, &h);
 
+    PhysicsWorld *physics_world = physics_world_create(PHYSICS_MAX_BODIES);
+    JobSystem *jobs = job_system_create(PHYSICS_THREADS);
     Character *character = character_create(
-        character_texture, (SDL_FRect){0, 0, w, h}, CHARACTER_SPEED,
-        CHARACTER_JUMP_STRENGTH, SCALING_FACTOR);
+        physics_world, character_texture, (SDL_FRect){0, 0, w, h},
+        CHARACTER_SPEED, CHARACTER_JUMP_STRENGTH, SCALING_FACTOR);
 
     LevelHashmap *levels = levels_load_from_dirs(
-        levels_dir_path, tileset, TILE_SIZE, TILE_SIZE, SCALING_FACTOR);
+        vfs, levels_dir_path, tileset, TILE_SIZE, TILE_SIZE, SCALING_FACTOR);
 
     Level *current_level = NULL;
+    SDL_FPoint character_position = character_get_position(character);
     level_select(&current_level, levels, starting_level_name,
-                 &character->hitbox);
+                 &character_position);
+    character_set_position(character, character_position);
 
     if (!current_level)
-        die("Level %s not found", starting_level_name);
+        die("Level %s not found", starting_level_name->str);
+
+    LevelCatalog *level_catalog = level_catalog_create(levels);
+    level_catalog_set_current(level_catalog, current_level);
 
     SDL_FPoint rendering_offset = {0};
 
+    Arena *frame_arena = arena_create(FRAME_ARENA_SIZE);
+    FrameProfiler *frame_profiler = frame_profiler_create();
+    TileOverlapTracker *tile_overlaps = tile_overlaps_create();
+
     CallbackGameState callback_game_state = {
         .level_ptr = &current_level,
         .levels = levels,
+        .level_catalog = level_catalog,
+        .rng = &rng,
         .character = character,
+        .frame_arena = frame_arena,
     };
 
+    Uint32 tick = 0;
     bool done = false;
     while (!done)
     {
-        SDL_SetRenderDrawColor(renderer, BACKGROUND_COLOR);
-        SDL_RenderClear(renderer);
+        frame_profiler_begin_frame(frame_profiler);
+        arena_reset(frame_arena);
+        alloc_stats_frame_begin();
 
         SDL_Event event;
-        while (SDL_PollEvent(&event))
+        while (poll_event(input_player, tick, &event))
         {
             switch (event.type)
             {
@@ -105,35 +186,116 @@ int main(int argc, char *argv[])
                     done = true;
                     break;
                 case SDL_KEYDOWN:
+                    if (event.key.keysym.sym == ALLOC_STATS_REPORT_KEY)
+                        alloc_stats_report();
+
                     tile_keyboard_events_notify(event_subscribers,
-                                                event.key.keysym.sym,
+                                                &event.key.keysym,
                                                 &callback_game_state);
                     /* fallthrough */
                 case SDL_KEYUP:
+                    if (input_recorder)
+                        input_recorder_record(input_recorder, tick, &event.key);
+
                     character_handle_keyboard_event(character, &event.key);
+                    break;
+                case SDL_KEYMAPCHANGED:
+                    // The keymap is compiled by scancode.
+                    tile_keyboard_events_invalidate(event_subscribers);
+                    break;
             }
         }
 
-        character_apply_gravity(character, GRAVITY);
-        character_tick(character, current_level->layers, MAX_ACCELERATION);
+        physics_world_step(physics_world, current_level->collision_mesh,
+                           current_level->solid_bitmap, GRAVITY, MAX_VELOCITY,
+                           jobs);
+
+        // Touch triggered callbacks run once the character has moved.
+        SDL_FRect character_hitbox = character_get_hitbox(character);
+        tile_overlaps_update(tile_overlaps, current_level, &character_hitbox);
+        tile_overlaps_dispatch(tile_overlaps, &callback_game_state);
+
+        // The bodies on or next to what the callbacks changed may not be at
+        // rest anymore.
+        SDL_FRect changed_area;
+        if (level_take_changed_area(current_level, &changed_area))
+            physics_world_wake_area(physics_world, &changed_area);
 
         calculate_rendering_offset(character, rendering_offset,
                                    &rendering_offset);
 
-        level_draw(current_level, renderer, &rendering_offset);
+        SDL_FPoint camera_center = {
+            WINDOW_WIDTH / 2.0f - rendering_offset.x,
+            WINDOW_HEIGHT / 2.0f - rendering_offset.y,
+        };
+        size_t active_bodies = physics_world_update_activity(
+            physics_world, camera_center, PHYSICS_ACTIVE_RADIUS);
+        frame_profiler_set_counter(frame_profiler,
+                                   FRAME_PROFILER_ACTIVE_BODIES,
+                                   active_bodies);
+        frame_profiler_set_counter(frame_profiler,
+                                   FRAME_PROFILER_SLEEPING_BODIES,
+                                   physics_world->count - active_bodies);
+
+        if (!input_player)
+        {
+            SDL_SetRenderDrawColor(renderer, BACKGROUND_COLOR);
+            SDL_RenderClear(renderer);
+
+            level_draw(current_level, renderer, &rendering_offset);
+
+            character_draw(character, renderer, &rendering_offset);
+        }
+
+        // Presenting waits for VSync, so the frame is measured before it.
+        frame_profiler_end_frame(frame_profiler);
+
+        tick++;
+        if (input_player)
+        {
+            done |= input_player_is_done(input_player, tick);
+            continue;
+        }
 
-        character_draw(character, renderer, &rendering_offset);
         SDL_RenderPresent(renderer);
 
         SDL_Delay(FRAME_DURATION);
     }
 
+    frame_profiler_report(frame_profiler);
+    if (frame_times_path)
+    {
+        FILE *frame_times_file = fopen(frame_times_path, "w");
+        if (!frame_times_file)
+            die("Opening %s failed: %s", frame_times_path, strerror(errno));
+
+        frame_profiler_write(frame_profiler, frame_times_file);
+        fclose(frame_times_file);
+    }
+    frame_profiler_destroy(frame_profiler);
+
+    if (input_recorder)
+        input_recorder_close(input_recorder, tick);
+    if (input_player)
+        input_player_destroy(input_player);
+
+    SDL_Log("Frame arena high-water mark: %zu of %d bytes",
+            frame_arena->high_water_mark, FRAME_ARENA_SIZE);
+    arena_destroy(frame_arena);
+    tile_overlaps_destroy(tile_overlaps);
+
+    alloc_stats_report();
+
     tile_keyboard_events_destroy(event_subscribers);
-    level_destroy(current_level);
+    level_catalog_destroy(level_catalog);
     levels_unload(levels);
     character_destroy(character);
+    job_system_destroy(jobs);
+    physics_world_destroy(physics_world);
     tileset_destroy(tileset);
     SDL_DestroyTexture(character_texture);
+    vfs_destroy(vfs);
+    intern_pool_destroy();
     quit_sdl(window, renderer);
 
     return EXIT_SUCCESS;
@@ -163,15 +325,21 @@ void calculate_rendering_offset(const Character *character,
           SDL_clamp(on_screen_pos.y, left_boundary, right_boundary));
 }
 
-void init_sdl(SDL_Window **window_ptr, SDL_Renderer **renderer_ptr)
+void init_sdl(SDL_Window **window_ptr, SDL_Renderer **renderer_ptr,
+              bool headless)
 {
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0)
         die("SDL_Init: %s", SDL_GetError());
 
-    if (SDL_CreateWindowAndRenderer(WINDOW_WIDTH, WINDOW_HEIGHT, 0, window_ptr,
-                                    renderer_ptr) < 0)
+    // Headless still needs a renderer, to load the textures.
+    if (SDL_CreateWindowAndRenderer(WINDOW_WIDTH, WINDOW_HEIGHT,
+                                    headless ? SDL_WINDOW_HIDDEN : 0,
+                                    window_ptr, renderer_ptr) < 0)
         die("SDL_CreateWindowAndRenderer: %s", SDL_GetError());
 
+    if (headless)
+        return;
+
     SDL_SetWindowTitle(*window_ptr, WINDOW_NAME);
     SDL_SetWindowPosition(*window_ptr, SDL_WINDOWPOS_CENTERED,
                           SDL_WINDOWPOS_CENTERED);
@@ -186,3 +354,16 @@ void quit_sdl(SDL_Window *window, SDL_Renderer *renderer)
     SDL_DestroyWindow(window);
     SDL_Quit();
 }
+
+bool poll_event(InputPlayer *input_player, Uint32 tick, SDL_Event *event)
+{
+    while (SDL_PollEvent(event))
+    {
+        bool is_keyboard_event =
+            event->type == SDL_KEYDOWN || event->type == SDL_KEYUP;
+        if (!input_player || !is_keyboard_event)
+            return true;
+    }
+
+    return input_player && input_player_poll(input_player, tick, event);
+}
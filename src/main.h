@@ -1,6 +1,8 @@
 #pragma once
 
 #include "character.h"
+#include "input_replay.h"
+#include <stdbool.h>
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
@@ -11,21 +13,49 @@
 
 #define WINDOW_NAME "Game"
 
+#define USAGE                                                                  \
+    "Usage: %s [-p <Asset pack path>] [-s <Random seed>] "                     \
+    "[-r <Record input to path> | -R <Replay input from path>] "               \
+    "[-t <Frame times output path>] <Character Texture Path> "                 \
+    "<Tileset Path> <Textures path> <KeyMap path> <Starting level name> "      \
+    "<Level dir path>"
+
 #define BACKGROUND_COLOR 0x00, 0x00, 0x00, 0xFF
 
 #define FPS 60
 
 #define FRAME_DURATION (1000 / FPS)
 
+// Size of the arena for the transient allocations of a single frame.
+#define FRAME_ARENA_SIZE (64 * 1024)
+
+// Logs the allocation statistics when built with ALLOC_STATS.
+#define ALLOC_STATS_REPORT_KEY SDLK_F3
+
 #define GRAVITY 0.9
 
 #define SCALING_FACTOR 2
 
 #define TILE_SIZE 16
 
-// NOTE: should not be larger than the smallest solid tile size.
-// Otherwise the character will be able to clip trough it.
-#define MAX_ACCELERATION (TILE_SIZE)
+// The terminal velocity of the character. Movement is swept, so it can be
+// larger than a tile without clipping through it.
+#define MAX_VELOCITY (TILE_SIZE)
+
+// The amount of bodies the physics world of the game holds.
+#define PHYSICS_MAX_BODIES 512
+
+// The amount of threads physics runs on, or 0 for a thread per CPU. Stepping
+// gives the same result on any amount, so replays don't depend on it. The
+// game only has the character, which is stepped as a single range on the
+// calling thread, so more threads would only sit idle (see bench_physics for
+// where they pay off).
+#define PHYSICS_THREADS 1
+
+// How far from the center of the screen bodies are simulated, past the
+// corners of the screen so the ones coming into view are already moving.
+// Further out, they sleep until it comes closer.
+#define PHYSICS_ACTIVE_RADIUS (WINDOW_WIDTH * 1.5)
 
 #define CHARACTER_SPEED 3
 #define CHARACTER_JUMP_STRENGTH 30
@@ -51,10 +81,24 @@ void calculate_rendering_offset(const Character *character,
  *
  * @param window_ptr Pointer to the SDL window to initialize
  * @param renderer_ptr Pointer to the SDL renderer to initialize
+ * @param headless Whether to hide the window, and leave VSync disabled.
  *
  * @see quit_sdl
  */
-void init_sdl(SDL_Window **window_ptr, SDL_Renderer **renderer_ptr);
+void init_sdl(SDL_Window **window_ptr, SDL_Renderer **renderer_ptr,
+              bool headless);
+
+/**
+ * @brief Polls for the next event of the tick. When playing a recording, the
+ *          keyboard is ignored and the recorded keyboard events are polled
+ *          instead.
+ *
+ * @param input_player The recording being played, or NULL.
+ * @param tick The current tick.
+ * @param[out] event The event.
+ * @return True if there was an event, false otherwise.
+ */
+bool poll_event(InputPlayer *input_player, Uint32 tick, SDL_Event *event);
 
 /**
  * @brief Destroys the given window and renderer and quits SDL.
@@ -0,0 +1,194 @@
+#include "pack.h"
+#include "utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+uint64_t pack_hash_path(const char *normalized_path)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+
+    for (const char *ch = normalized_path; *ch; ch++)
+    {
+        hash ^= (unsigned char)*ch;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+bool pack_normalize_path(const char *path, char *out, size_t out_size)
+{
+    size_t len = 0;
+
+    while (path[0] == '.' && path[1] == '/')
+    {
+        path += 2;
+        while (*path == '/')
+            path++;
+    }
+
+    for (; *path; path++)
+    {
+        if (*path == '/' && (path[1] == '/' || path[1] == '\0'))
+            continue;
+
+        if (len + 1 >= out_size)
+            return false;
+
+        out[len++] = *path;
+    }
+
+    if (len >= out_size)
+        return false;
+
+    out[len] = '\0';
+
+    return true;
+}
+
+/**
+ * @brief Checks that the header of a mapped pack is in bounds and that the TOC
+ *          and the strings table it points to are.
+ */
+static bool pack_validate_header(const Pack *pack)
+{
+    if (pack->size < sizeof(PackHeader))
+        return false;
+
+    const PackHeader *header = pack->header;
+
+    if (memcmp(header->magic, PACK_MAGIC, PACK_MAGIC_SIZE) != 0 ||
+        header->version != PACK_VERSION)
+        return false;
+
+    return header->toc_offset <= pack->size &&
+           (pack->size - header->toc_offset) / sizeof(PackEntry) >=
+               header->entry_count &&
+           header->strings_offset <= pack->size;
+}
+
+/**
+ * @brief Checks that the entries of a pack and their null terminated paths are
+ *          in bounds.
+ */
+static bool pack_validate_toc(const Pack *pack)
+{
+    size_t strings_size = pack->size - pack->header->strings_offset;
+    const PackEntry *entries_end = pack->entries + pack->header->entry_count;
+    for (const PackEntry *entry = pack->entries; entry < entries_end; entry++)
+    {
+        if (entry->offset > pack->size ||
+            entry->length > pack->size - entry->offset ||
+            entry->path_offset >= strings_size ||
+            !memchr(pack->strings + entry->path_offset, '\0',
+                    strings_size - entry->path_offset) ||
+            entry->compression != PACK_COMPRESSION_NONE)
+            return false;
+    }
+
+    return true;
+}
+
+Pack *pack_open(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file referenced.
+
+    if (data == MAP_FAILED)
+        return NULL;
+
+    Pack *pack = xmalloc(sizeof(*pack));
+    pack->data = data;
+    pack->size = st.st_size;
+    pack->header = data;
+    pack->entries = NULL;
+    pack->strings = NULL;
+
+    // The TOC and the strings are only located once the header is known to
+    // be in bounds.
+    bool valid = pack_validate_header(pack);
+    if (valid)
+    {
+        pack->entries =
+            (const PackEntry *)(pack->data + pack->header->toc_offset);
+        pack->strings =
+            (const char *)(pack->data + pack->header->strings_offset);
+        valid = pack_validate_toc(pack);
+    }
+
+    if (!valid)
+    {
+        pack_close(pack);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return pack;
+}
+
+void pack_close(Pack *pack)
+{
+    munmap((void *)pack->data, pack->size);
+    free(pack);
+}
+
+const PackEntry *pack_find(const Pack *pack, const char *path)
+{
+    char normalized_path[PACK_PATH_MAX];
+    if (!pack_normalize_path(path, normalized_path, sizeof(normalized_path)))
+        return NULL;
+
+    uint64_t hash = pack_hash_path(normalized_path);
+
+    // Binary search for the first entry with the hash
+    size_t low = 0;
+    size_t high = pack->header->entry_count;
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (pack->entries[mid].path_hash < hash)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    // Paths are compared as well, in case of a hash collision
+    for (size_t i = low; i < pack->header->entry_count &&
+                         pack->entries[i].path_hash == hash;
+         i++)
+    {
+        if (strcmp(pack_entry_path(pack, &pack->entries[i]),
+                   normalized_path) == 0)
+            return &pack->entries[i];
+    }
+
+    return NULL;
+}
+
+const void *pack_entry_data(const Pack *pack, const PackEntry *entry)
+{
+    return pack->data + entry->offset;
+}
+
+const char *pack_entry_path(const Pack *pack, const PackEntry *entry)
+{
+    return pack->strings + entry->path_offset;
+}
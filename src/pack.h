@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Asset pack layout (all integers are stored in host byte order):
+ *
+ *  PackHeader
+ *  PackEntry[entry_count]     - The TOC, sorted by path_hash.
+ *  char strings[]             - Null terminated normalized entry paths.
+ *  (padding)
+ *  entry data                 - Every entry starts on a PACK_ALIGNMENT
+ *                               boundary, so it can be used directly from the
+ *                               mapped file.
+ */
+
+#define PACK_MAGIC "ADPK"
+#define PACK_MAGIC_SIZE 4
+#define PACK_VERSION 1
+#define PACK_ALIGNMENT 4096
+
+#define PACK_PATH_MAX 4096
+
+typedef enum PackCompression
+{
+    PACK_COMPRESSION_NONE,
+} PackCompression;
+
+typedef struct PackHeader
+{
+    char magic[PACK_MAGIC_SIZE];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+    uint64_t toc_offset;
+    uint64_t strings_offset;
+} PackHeader;
+
+typedef struct PackEntry
+{
+    uint64_t path_hash;
+    uint64_t offset; // From the start of the pack file.
+    uint64_t length;
+    uint32_t path_offset; // From the start of the strings table.
+    uint32_t compression; // PackCompression
+} PackEntry;
+
+typedef struct Pack
+{
+    const uint8_t *data; // The whole pack file, mapped read only.
+    size_t size;
+    const PackHeader *header;
+    const PackEntry *entries;
+    const char *strings;
+} Pack;
+
+/**
+ * @brief Maps a pack file into memory and validates its header and TOC.
+ *
+ * @param path The path to the pack file.
+ * @return The opened pack, or NULL on failure (errno is set).
+ *
+ * @see pack_close
+ */
+Pack *pack_open(const char *path);
+
+/**
+ * @brief Unmaps the pack file and frees the pack.
+ *
+ * @warning All the pointers to the pack data become invalid.
+ */
+void pack_close(Pack *pack);
+
+/**
+ * @brief Finds an entry in the pack by its path.
+ *
+ * @param path The path of the entry. Normalized before the lookup.
+ * @return The entry, or NULL if there is no entry with the given path.
+ *
+ * @see pack_normalize_path
+ */
+const PackEntry *pack_find(const Pack *pack, const char *path);
+
+/**
+ * @brief Gets the data of an entry.
+ *
+ * @return Pointer to `entry->length` bytes of entry's data.
+ */
+const void *pack_entry_data(const Pack *pack, const PackEntry *entry);
+
+/**
+ * @brief Gets the (normalized) path of an entry.
+ */
+const char *pack_entry_path(const Pack *pack, const PackEntry *entry);
+
+/**
+ * @brief Normalizes a path the way it's stored in the pack - leading "./" and
+ *          repeated or trailing separators are removed.
+ *
+ * @param path The path to normalize.
+ * @param[out] out Buffer for the normalized path.
+ * @param out_size The size of the out buffer.
+ * @return True on success, false if the normalized path does not fit in out.
+ */
+bool pack_normalize_path(const char *path, char *out, size_t out_size);
+
+/**
+ * @brief Hashes a normalized path (64 bit FNV-1a).
+ */
+uint64_t pack_hash_path(const char *normalized_path);
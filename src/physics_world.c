@@ -0,0 +1,373 @@
+#include "SDL.h"
+#include "arena.h"
+#include "collision_mesh.h"
+#include "job_system.h"
+#include "level_layer.h"
+#include "physics_world.h"
+#include "solid_bitmap.h"
+#include "tile.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#define PHYSICS_COLLISION_y_NEGATIVE PHYSICS_COLLISION_TOP
+#define PHYSICS_COLLISION_y_POSITIVE PHYSICS_COLLISION_BOTTOM
+#define PHYSICS_COLLISION_x_NEGATIVE PHYSICS_COLLISION_LEFT
+#define PHYSICS_COLLISION_x_POSITIVE PHYSICS_COLLISION_RIGHT
+
+// The candidates of a movement are collected in a small vector shared by all
+// the bodies of a job, so unless a body sweeps over more tiles than this,
+// finding them doesn't allocate.
+#define PHYSICS_WORLD_COLLISIONS_INLINE_CAPACITY 16
+
+// The amount of bodies a job of a step moves.
+#define PHYSICS_WORLD_JOB_GRAIN 64
+
+// What the jobs of a step share, all of it only read but the bodies.
+typedef struct PhysicsWorldStep
+{
+    PhysicsWorld *world;
+    const CollisionMesh *collision_mesh;
+    const SolidBitmap *solid_bitmap;
+    float gravity;
+    float max_velocity;
+} PhysicsWorldStep;
+
+// The solid bitmap query which finds the first blocking cell on an axis.
+#define physics_world_find_first_solid_x solid_bitmap_find_first_column
+#define physics_world_find_first_solid_y solid_bitmap_find_first_row
+
+/**
+ * @brief Moves a body along an axis, stopping at the first solid tile in the
+ *          way (swept AABB). The candidates are the solid tiles in the area
+ *          the hitbox moves into, from the first solid cell of that area on,
+ *          so no speed tunnels through a tile, and moving through clear cells
+ *          takes no more than a look at the bitmap.
+ *
+ * @param body The index of the body.
+ * @param collision_mesh The solid geometry of the level.
+ * @param solid_bitmap The solid cells of the level.
+ * @param candidates The vector to collect the candidates in, emptied first.
+ * @param movement_delta How much to move by.
+ * @param pos_axis `x` or `y`
+ * @param size_axis `w` or `h`
+ */
+#define physics_world_sweep_on_axis(world, body, collision_mesh, solid_bitmap, \
+                                    candidates, movement_delta, pos_axis,      \
+                                    size_axis)                                 \
+    {                                                                          \
+        const VecTile rects = (collision_mesh)->rects->tiles;                  \
+        float *pos = &(world)->pos_axis[body];                                 \
+        float size = (world)->size_axis[body];                                 \
+        (world)->collisions[body] &=                                           \
+            ~((PHYSICS_COLLISION_##pos_axis##_NEGATIVE) |                      \
+              (PHYSICS_COLLISION_##pos_axis##_POSITIVE));                      \
+                                                                               \
+        SDL_FRect ahead = physics_world_get_hitbox(world, body);               \
+        ahead.pos_axis += movement_delta < 0 ? movement_delta : size;          \
+        ahead.size_axis = SDL_fabsf(movement_delta);                           \
+                                                                               \
+        int first_solid =                                                      \
+            movement_delta == 0                                                \
+                ? -1                                                           \
+                : physics_world_find_first_solid_##pos_axis(                   \
+                      solid_bitmap, &ahead, movement_delta > 0);               \
+                                                                               \
+        vector_resize(candidates, 0);                                          \
+        if (first_solid != -1)                                                 \
+        {                                                                      \
+            /* No tile in the way starts before the first solid cell. */      \
+            float cell_size = (solid_bitmap)->cell_size.pos_axis;              \
+            float cell_start =                                                 \
+                (solid_bitmap)->origin.pos_axis + first_solid * cell_size;     \
+            float ahead_end = ahead.pos_axis + ahead.size_axis;                \
+            if (movement_delta > 0)                                            \
+                ahead.pos_axis = SDL_max(ahead.pos_axis, cell_start);          \
+            else                                                               \
+                ahead_end = SDL_min(ahead_end, cell_start + cell_size);        \
+            ahead.size_axis = ahead_end - ahead.pos_axis;                      \
+                                                                               \
+            collision_mesh_find_collisions(collision_mesh, &ahead,             \
+                                           candidates);                        \
+        }                                                                      \
+                                                                               \
+        float target = *pos + movement_delta;                                  \
+        PhysicsCollisionDirection collision_direction = 0;                     \
+        vector_iter(index, *(candidates))                                      \
+        {                                                                      \
+            const SDL_FRect *tile_hitbox = &rects[*index].hitbox;              \
+                                                                               \
+            /* Tiles behind the leading edge were passed already. */           \
+            if (movement_delta > 0 &&                                          \
+                tile_hitbox->pos_axis + tile_hitbox->size_axis > *pos + size)  \
+            {                                                                  \
+                float stop = tile_hitbox->pos_axis - size;                     \
+                if (stop <= target)                                            \
+                {                                                              \
+                    target = stop;                                             \
+                    collision_direction =                                      \
+                        (PHYSICS_COLLISION_##pos_axis##_POSITIVE);             \
+                }                                                              \
+            }                                                                  \
+            else if (movement_delta < 0 && tile_hitbox->pos_axis < *pos)       \
+            {                                                                  \
+                float stop = tile_hitbox->pos_axis + tile_hitbox->size_axis;   \
+                if (stop >= target)                                            \
+                {                                                              \
+                    target = stop;                                             \
+                    collision_direction =                                      \
+                        (PHYSICS_COLLISION_##pos_axis##_NEGATIVE);             \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+                                                                               \
+        *pos = target;                                                         \
+        if (collision_direction)                                               \
+            (world)->velocity_##pos_axis[body] = 0;                            \
+        (world)->collisions[body] |= collision_direction;                      \
+    }
+
+/**
+ * @brief Calculates the size of each array of a world, so the one after it
+ *          stays aligned.
+ */
+static size_t physics_world_array_size(size_t capacity, size_t element_size)
+{
+    return ARENA_ALIGN(capacity * element_size);
+}
+
+PhysicsWorld *physics_world_create(size_t capacity)
+{
+    size_t floats_size = physics_world_array_size(capacity, sizeof(float));
+    size_t ids_size = physics_world_array_size(capacity, sizeof(PhysicsBodyId));
+    size_t flags_size = physics_world_array_size(capacity, sizeof(Uint8));
+
+    // The world and its arrays are a single allocation: the hitboxes, the
+    // velocities and the speeds, the active bodies, then the movement and
+    // collision flags, the rest ticks and whether the bodies are asleep.
+    size_t header_size = ARENA_ALIGN(sizeof(PhysicsWorld));
+    size_t size = header_size + 7 * floats_size + ids_size + 4 * flags_size;
+    PhysicsWorld *world = xmalloc(size);
+    memset(world, 0, size);
+    world->capacity = capacity;
+
+    char *arrays = (char *)world + header_size;
+    float **float_arrays[] = {
+        &world->x,          &world->y,          &world->w,     &world->h,
+        &world->velocity_x, &world->velocity_y, &world->speed,
+    };
+    for (size_t i = 0; i < SDL_arraysize(float_arrays); i++)
+    {
+        *float_arrays[i] = (float *)arrays;
+        arrays += floats_size;
+    }
+    world->active = (PhysicsBodyId *)arrays;
+    arrays += ids_size;
+    world->movement_direction = (PhysicsMovementDirection *)arrays;
+    world->collisions = (PhysicsCollisionDirection *)(arrays + flags_size);
+    world->rest_ticks = (Uint8 *)(arrays + 2 * flags_size);
+    world->asleep = (bool *)(arrays + 3 * flags_size);
+
+    return world;
+}
+
+void physics_world_destroy(PhysicsWorld *world)
+{
+    free(world);
+}
+
+PhysicsBodyId physics_world_add_body(PhysicsWorld *world, SDL_FRect hitbox,
+                                     float speed)
+{
+    if (world->count == world->capacity)
+        die("The physics world is full (%zu bodies)", world->capacity);
+
+    PhysicsBodyId body = world->count++;
+    world->x[body] = hitbox.x;
+    world->y[body] = hitbox.y;
+    world->w[body] = hitbox.w;
+    world->h[body] = hitbox.h;
+    world->velocity_x[body] = 0;
+    world->velocity_y[body] = 0;
+    world->speed[body] = speed;
+    world->movement_direction[body] = 0;
+    world->collisions[body] = 0;
+    world->rest_ticks[body] = 0;
+    world->asleep[body] = false;
+    world->active[world->active_count++] = body;
+
+    return body;
+}
+
+SDL_FRect physics_world_get_hitbox(const PhysicsWorld *world,
+                                   PhysicsBodyId body)
+{
+    return (SDL_FRect){world->x[body], world->y[body], world->w[body],
+                       world->h[body]};
+}
+
+void physics_world_set_position(PhysicsWorld *world, PhysicsBodyId body,
+                                SDL_FPoint position)
+{
+    world->x[body] = position.x;
+    world->y[body] = position.y;
+    physics_world_wake_body(world, body);
+}
+
+void physics_world_wake_body(PhysicsWorld *world, PhysicsBodyId body)
+{
+    world->rest_ticks[body] = 0;
+    if (!world->asleep[body])
+        return;
+
+    world->asleep[body] = false;
+    world->active[world->active_count++] = body;
+}
+
+void physics_world_wake_area(PhysicsWorld *world, const SDL_FRect *area)
+{
+    for (PhysicsBodyId body = 0; body < world->count; body++)
+    {
+        // Unlike SDL_HasIntersectionF, touching counts, as a body standing on
+        // a tile only touches it.
+        if (world->x[body] <= area->x + area->w &&
+            area->x <= world->x[body] + world->w[body] &&
+            world->y[body] <= area->y + area->h &&
+            area->y <= world->y[body] + world->h[body])
+            physics_world_wake_body(world, body);
+    }
+}
+
+size_t physics_world_update_activity(PhysicsWorld *world, SDL_FPoint center,
+                                     float radius)
+{
+    // The list is rebuilt in the order of the ids, so the bodies of a job
+    // don't depend on the order they were woken in.
+    world->active_count = 0;
+    for (PhysicsBodyId body = 0; body < world->count; body++)
+    {
+        // The distance to the closest point of the hitbox.
+        SDL_FRect hitbox = physics_world_get_hitbox(world, body);
+        float dx = SDL_max(SDL_max(hitbox.x - center.x,
+                                   center.x - (hitbox.x + hitbox.w)),
+                           0);
+        float dy = SDL_max(SDL_max(hitbox.y - center.y,
+                                   center.y - (hitbox.y + hitbox.h)),
+                           0);
+        bool in_radius = dx * dx + dy * dy <= radius * radius;
+
+        world->asleep[body] =
+            !in_radius || world->rest_ticks[body] >= PHYSICS_WORLD_SLEEP_TICKS;
+        if (!world->asleep[body])
+            world->active[world->active_count++] = body;
+    }
+
+    return world->active_count;
+}
+
+/*
+ * @brief Calculates the horizontal movement of a body for this step, its
+ *          velocity and its own movement.
+ */
+static float physics_world_horizontal_movement_delta(const PhysicsWorld *world,
+                                                     PhysicsBodyId body)
+{
+    float delta = world->velocity_x[body];
+    if (world->movement_direction[body] & PHYSICS_MOVE_RIGHT)
+        delta += world->speed[body];
+    if (world->movement_direction[body] & PHYSICS_MOVE_LEFT)
+        delta -= world->speed[body];
+
+    return delta;
+}
+
+/**
+ * @brief Counts the steps in a row a body ended at rest: standing on the
+ *          ground, with no velocity, and not moving on its own. Stepping it
+ *          again then leaves it exactly as it is.
+ */
+static void physics_world_count_rest(PhysicsWorld *world, PhysicsBodyId body)
+{
+    bool at_rest = world->velocity_x[body] == 0 &&
+                   world->velocity_y[body] == 0 &&
+                   !world->movement_direction[body] &&
+                   (world->collisions[body] & PHYSICS_COLLISION_BOTTOM);
+    if (!at_rest)
+        world->rest_ticks[body] = 0;
+    else if (world->rest_ticks[body] < PHYSICS_WORLD_SLEEP_TICKS)
+        world->rest_ticks[body]++;
+}
+
+/**
+ * @brief Steps the active bodies [first, last), a job of physics_world_step.
+ *
+ * @see JobFunction
+ */
+static void physics_world_step_bodies(void *data, size_t first, size_t last,
+                                      Arena *scratch)
+{
+    const PhysicsWorldStep *step = data;
+    PhysicsWorld *world = step->world;
+    const CollisionMesh *collision_mesh = step->collision_mesh;
+    const SolidBitmap *solid_bitmap = step->solid_bitmap;
+    const PhysicsBodyId *active = world->active;
+
+    for (size_t k = first; k < last; k++)
+    {
+        world->velocity_y[active[k]] += step->gravity;
+    }
+
+    for (size_t k = first; k < last; k++)
+    {
+        PhysicsBodyId i = active[k];
+        world->velocity_x[i] = SDL_clamp(world->velocity_x[i],
+                                         -step->max_velocity,
+                                         step->max_velocity);
+        world->velocity_y[i] = SDL_clamp(world->velocity_y[i],
+                                         -step->max_velocity,
+                                         step->max_velocity);
+    }
+
+    // Bodies don't collide with each other, so moving all of them vertically
+    // and then all of them horizontally is the same as one at a time.
+    vector_small_in(scratch, Uint32, candidates,
+                    PHYSICS_WORLD_COLLISIONS_INLINE_CAPACITY);
+    for (size_t k = first; k < last; k++)
+    {
+        PhysicsBodyId i = active[k];
+        float movement_delta = world->velocity_y[i];
+        physics_world_sweep_on_axis(world, i, collision_mesh, solid_bitmap,
+                                    &candidates, movement_delta, y, h);
+    }
+
+    for (size_t k = first; k < last; k++)
+    {
+        PhysicsBodyId i = active[k];
+        float movement_delta =
+            physics_world_horizontal_movement_delta(world, i);
+        physics_world_sweep_on_axis(world, i, collision_mesh, solid_bitmap,
+                                    &candidates, movement_delta, x, w);
+        physics_world_count_rest(world, i);
+    }
+    vector_free(candidates);
+}
+
+void physics_world_step(PhysicsWorld *world,
+                        const CollisionMesh *collision_mesh,
+                        const SolidBitmap *solid_bitmap, float gravity,
+                        float max_velocity, JobSystem *jobs)
+{
+    // Each awake body is moved by one job, from nothing but its own entries
+    // and the level, so the result is the same on any amount of threads.
+    PhysicsWorldStep step = {
+        .world = world,
+        .collision_mesh = collision_mesh,
+        .solid_bitmap = solid_bitmap,
+        .gravity = gravity,
+        .max_velocity = max_velocity,
+    };
+    job_system_parallel_for(jobs, world->active_count, PHYSICS_WORLD_JOB_GRAIN,
+                            physics_world_step_bodies, &step);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "SDL.h"
+#include "collision_mesh.h"
+#include "job_system.h"
+#include "solid_bitmap.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef Uint8 PhysicsMovementDirection;
+
+#define PHYSICS_MOVE_LEFT (PhysicsMovementDirection)0x01  // 0b01
+#define PHYSICS_MOVE_RIGHT (PhysicsMovementDirection)0x02 // 0b10
+
+typedef Uint8 PhysicsCollisionDirection;
+
+#define PHYSICS_COLLISION_TOP (PhysicsCollisionDirection)0x01
+#define PHYSICS_COLLISION_BOTTOM (PhysicsCollisionDirection)0x02
+#define PHYSICS_COLLISION_LEFT (PhysicsCollisionDirection)0x04
+#define PHYSICS_COLLISION_RIGHT (PhysicsCollisionDirection)0x08
+
+// A body of a world, the index of its entry in each of the arrays.
+typedef Uint32 PhysicsBodyId;
+
+// The amount of steps in a row a body has to end at rest before it can sleep.
+#define PHYSICS_WORLD_SLEEP_TICKS 30
+
+/*
+ * The moving bodies of a level (the character, the enemies), as a structure of
+ * arrays, so a step goes over each stage of the physics for all of them in a
+ * flat loop instead of a chain of calls per body. Bodies collide with the
+ * solid tiles, not with each other.
+ *
+ * Only the awake bodies are stepped. A body sleeps when it's far from the
+ * camera, or once it has been at rest for a while, where stepping it would
+ * leave it as it is anyway, and is woken when it's moved or what it stands on
+ * changes.
+ */
+typedef struct PhysicsWorld
+{
+    size_t count;
+    size_t capacity;
+
+    // The hitbox of body i is {x[i], y[i], w[i], h[i]}.
+    float *x;
+    float *y;
+    float *w;
+    float *h;
+    float *velocity_x;
+    float *velocity_y;
+    float *speed; // How fast a body moves on its own, on top of its velocity.
+    PhysicsMovementDirection *movement_direction;
+    PhysicsCollisionDirection *collisions; // What stopped it in the last step.
+    Uint8 *rest_ticks; // The steps in a row it ended at rest, up to
+                       // PHYSICS_WORLD_SLEEP_TICKS.
+    bool *asleep;
+
+    // The awake bodies, the ones a step goes over.
+    PhysicsBodyId *active;
+    size_t active_count;
+} PhysicsWorld;
+
+/**
+ * @brief Creates an empty world.
+ *
+ * @param capacity The maximal amount of bodies.
+ * @return The created world, in a single allocation.
+ *
+ * @see physics_world_destroy
+ */
+PhysicsWorld *physics_world_create(size_t capacity);
+
+/**
+ * @brief Frees the world.
+ */
+void physics_world_destroy(PhysicsWorld *world);
+
+/**
+ * @brief Adds an awake body with no velocity, which isn't moving on its own.
+ *          Dies if the world is full.
+ *
+ * @param hitbox The hitbox of the body.
+ * @param speed How fast the body moves in its movement direction.
+ * @return The added body.
+ */
+PhysicsBodyId physics_world_add_body(PhysicsWorld *world, SDL_FRect hitbox,
+                                     float speed);
+
+/**
+ * @brief Gets the hitbox of a body.
+ */
+SDL_FRect physics_world_get_hitbox(const PhysicsWorld *world,
+                                   PhysicsBodyId body);
+
+/**
+ * @brief Moves a body to a position, without sweeping it there, and wakes it.
+ *
+ * @param position The new top left corner of the body's hitbox.
+ */
+void physics_world_set_position(PhysicsWorld *world, PhysicsBodyId body,
+                                SDL_FPoint position);
+
+/**
+ * @brief Wakes a body, which then stays awake for at least
+ *          PHYSICS_WORLD_SLEEP_TICKS steps unless it's far from the camera.
+ *          Must be called when anything but a step changes its velocity or
+ *          its movement.
+ */
+void physics_world_wake_body(PhysicsWorld *world, PhysicsBodyId body);
+
+/**
+ * @brief Wakes the bodies which overlap or touch an area, e.g. the tiles which
+ *          changed.
+ */
+void physics_world_wake_area(PhysicsWorld *world, const SDL_FRect *area);
+
+/**
+ * @brief Decides which bodies the next steps go over: the ones within the
+ *          radius of the camera are awake unless they've been at rest for
+ *          PHYSICS_WORLD_SLEEP_TICKS steps, and the others sleep, wherever
+ *          they are, until they're within it again.
+ *
+ * @param center The center of the camera.
+ * @param radius How far from the center bodies are simulated, up to the
+ *                  closest point of their hitbox.
+ * @return The amount of awake bodies. The others are asleep.
+ */
+size_t physics_world_update_activity(PhysicsWorld *world, SDL_FPoint center,
+                                     float radius);
+
+/**
+ * @brief Steps every awake body by a tick: applies gravity, clamps the
+ *          velocities, and then moves the bodies, stopping them at the solid
+ *          tiles in their way, vertically and then horizontally. Doesn't
+ *          tunnel through tiles at any velocity. The bodies are split between
+ *          the threads of the job system, and the result doesn't depend on
+ *          how.
+ *
+ * @param collision_mesh The solid geometry of the level, which the bodies
+ *                          collide with.
+ * @param solid_bitmap The solid cells of the level, to skip the clear ones.
+ * @param gravity The acceleration of gravity.
+ * @param max_velocity The maximum velocity a body can have in any direction.
+ * @param jobs The job system to step the bodies on.
+ */
+void physics_world_step(PhysicsWorld *world,
+                        const CollisionMesh *collision_mesh,
+                        const SolidBitmap *solid_bitmap, float gravity,
+                        float max_velocity, JobSystem *jobs);
@@ -0,0 +1,61 @@
+#include "rng.h"
+#include <stdint.h>
+
+static uint64_t rng_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Advances the splitmix64 state and returns its next output.
+ */
+static uint64_t rng_splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *rng, uint64_t seed)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        rng->state[i] = rng_splitmix64(&seed);
+    }
+}
+
+uint64_t rng_next(Rng *rng)
+{
+    uint64_t *s = rng->state;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+uint32_t rng_below(Rng *rng, uint32_t bound)
+{
+    // The high half of x * bound is in [0, bound). The low half tells if x
+    // was in a range that maps to one value more often, and is redrawn then.
+    uint64_t product = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+    uint32_t low = (uint32_t)product;
+    if (low < bound)
+    {
+        uint32_t threshold = -bound % bound;
+        while (low < threshold)
+        {
+            product = (uint64_t)(uint32_t)(rng_next(rng) >> 32) * bound;
+            low = (uint32_t)product;
+        }
+    }
+
+    return product >> 32;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * A seedable pseudo random number generator (xoshiro256**). Its sequence
+ * depends only on the seed, so runs with the same seed make the same random
+ * choices.
+ */
+typedef struct Rng
+{
+    uint64_t state[4];
+} Rng;
+
+/**
+ * @brief Seeds the generator. The state is filled from the seed with
+ *          splitmix64, so any seed (including 0) is fine.
+ *
+ * @param seed The seed.
+ */
+void rng_seed(Rng *rng, uint64_t seed);
+
+/**
+ * @brief Generates the next random number.
+ *
+ * @return A uniformly distributed 64 bit number.
+ */
+uint64_t rng_next(Rng *rng);
+
+/**
+ * @brief Generates a random number below the given bound, without the bias
+ *          of taking the remainder (Lemire's method).
+ *
+ * @param bound The exclusive upper bound, must be positive.
+ * @return A uniformly distributed number in [0, bound).
+ */
+uint32_t rng_below(Rng *rng, uint32_t bound);
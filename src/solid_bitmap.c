@@ -0,0 +1,330 @@
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+
+#include "SDL.h"
+#include "arena.h"
+#include "solid_bitmap.h"
+#include "tile.h"
+#include "utils.h"
+#include "vec.h"
+#include <string.h>
+
+#define SOLID_BITMAP_WORD_BITS 64
+
+// The cells a rectangle covers, inclusive.
+typedef struct SolidBitmapCellRange
+{
+    int first_column, last_column;
+    int first_row, last_row;
+} SolidBitmapCellRange;
+
+/**
+ * @brief Finds the cells the rectangle covers, which may be outside of the
+ *          bitmap.
+ *
+ * @param touching_columns Whether the columns the rectangle only touches are
+ *                          included, or only the ones it overlaps.
+ * @param touching_rows Whether the rows the rectangle only touches are
+ *                          included, or only the ones it overlaps.
+ */
+static SolidBitmapCellRange solid_bitmap_cell_range(const SolidBitmap *bitmap,
+                                                    const SDL_FRect *rect,
+                                                    bool touching_columns,
+                                                    bool touching_rows)
+{
+    float left = (rect->x - bitmap->origin.x) / bitmap->cell_size.x;
+    float top = (rect->y - bitmap->origin.y) / bitmap->cell_size.y;
+    float right = left + rect->w / bitmap->cell_size.x;
+    float bottom = top + rect->h / bitmap->cell_size.y;
+
+    // A rectangle which only touches a cell ends right at the cell's start.
+    SolidBitmapCellRange range = {
+        .first_column = (int)SDL_floorf(left),
+        .first_row = (int)SDL_floorf(top),
+        .last_column = (int)(touching_columns ? SDL_floorf(right)
+                                              : SDL_ceilf(right) - 1),
+        .last_row = (int)(touching_rows ? SDL_floorf(bottom)
+                                        : SDL_ceilf(bottom) - 1),
+    };
+    range.last_column = SDL_max(range.last_column, range.first_column);
+    range.last_row = SDL_max(range.last_row, range.first_row);
+
+    return range;
+}
+
+/**
+ * @brief Clamps the range to the bitmap.
+ *
+ * @return False if the range is outside of the bitmap.
+ */
+static bool solid_bitmap_clamp(const SolidBitmap *bitmap,
+                               SolidBitmapCellRange *range)
+{
+    if (range->last_column < 0 || range->last_row < 0 ||
+        range->first_column >= bitmap->columns ||
+        range->first_row >= bitmap->rows)
+        return false;
+
+    range->first_column = SDL_max(range->first_column, 0);
+    range->first_row = SDL_max(range->first_row, 0);
+    range->last_column = SDL_min(range->last_column, bitmap->columns - 1);
+    range->last_row = SDL_min(range->last_row, bitmap->rows - 1);
+
+    return true;
+}
+
+/**
+ * @brief Gets the bits of the columns first..last (inclusive) which are in
+ *          the word at the given index of a row.
+ */
+static Uint64 solid_bitmap_span_mask(int word, int first, int last)
+{
+    int low = SDL_max(first - word * SOLID_BITMAP_WORD_BITS, 0);
+    int high = SDL_min(last - word * SOLID_BITMAP_WORD_BITS,
+                       SOLID_BITMAP_WORD_BITS - 1);
+
+    return (~(Uint64)0 << low) &
+           (~(Uint64)0 >> (SOLID_BITMAP_WORD_BITS - 1 - high));
+}
+
+static Uint64 *solid_bitmap_row(const SolidBitmap *bitmap, int row)
+{
+    return &bitmap->words[(size_t)row * bitmap->row_words];
+}
+
+/**
+ * @brief Sets or clears the cells in the range, which must be in the bitmap.
+ */
+static void solid_bitmap_fill(SolidBitmap *bitmap,
+                              const SolidBitmapCellRange *range, bool solid)
+{
+    int first_word = range->first_column / SOLID_BITMAP_WORD_BITS;
+    int last_word = range->last_column / SOLID_BITMAP_WORD_BITS;
+    for (int row = range->first_row; row <= range->last_row; row++)
+    {
+        Uint64 *words = solid_bitmap_row(bitmap, row);
+        for (int word = first_word; word <= last_word; word++)
+        {
+            Uint64 mask = solid_bitmap_span_mask(word, range->first_column,
+                                                 range->last_column);
+            if (solid)
+                words[word] |= mask;
+            else
+                words[word] &= ~mask;
+        }
+    }
+}
+
+/**
+ * @brief Finds the first solid column among the columns first..last
+ *          (inclusive) of a row.
+ *
+ * @return The column, or -1 if they are all clear.
+ */
+static int solid_bitmap_row_find(const SolidBitmap *bitmap, int row, int first,
+                                 int last, bool rightwards)
+{
+    const Uint64 *words = solid_bitmap_row(bitmap, row);
+    int first_word = first / SOLID_BITMAP_WORD_BITS;
+    int last_word = last / SOLID_BITMAP_WORD_BITS;
+    for (int i = 0; i <= last_word - first_word; i++)
+    {
+        int word = rightwards ? first_word + i : last_word - i;
+        Uint64 bits = words[word] & solid_bitmap_span_mask(word, first, last);
+        if (!bits)
+            continue;
+
+        int bit = rightwards
+                      ? __builtin_ctzll(bits)
+                      : SOLID_BITMAP_WORD_BITS - 1 - __builtin_clzll(bits);
+        return word * SOLID_BITMAP_WORD_BITS + bit;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Checks if the tile makes the cells it overlaps solid. Empty tiles
+ *          never collide, like in SDL_HasIntersectionF.
+ */
+static bool solid_bitmap_is_marked_by(const Tile *tile)
+{
+    return tile_is_solid(tile) && tile->hitbox.w > 0 && tile->hitbox.h > 0;
+}
+
+SolidBitmap *solid_bitmap_create(const VecLevelLayer layers,
+                                 SDL_FPoint cell_size)
+{
+    float min_x = INFINITY, min_y = INFINITY;
+    float max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!level_layer_is_collidable(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            if (!solid_bitmap_is_marked_by(tile))
+                continue;
+
+            min_x = SDL_min(min_x, tile->hitbox.x);
+            min_y = SDL_min(min_y, tile->hitbox.y);
+            max_x = SDL_max(max_x, tile->hitbox.x + tile->hitbox.w);
+            max_y = SDL_max(max_y, tile->hitbox.y + tile->hitbox.h);
+        }
+    }
+
+    SolidBitmap header = {.cell_size = cell_size};
+    if (min_x != INFINITY) // Otherwise there is nothing solid, and no cells.
+    {
+        header.origin = (SDL_FPoint){
+            SDL_floorf(min_x / cell_size.x) * cell_size.x,
+            SDL_floorf(min_y / cell_size.y) * cell_size.y,
+        };
+        header.columns = SDL_max(
+            (int)SDL_ceilf((max_x - header.origin.x) / cell_size.x), 1);
+        header.rows = SDL_max(
+            (int)SDL_ceilf((max_y - header.origin.y) / cell_size.y), 1);
+        header.row_words = (header.columns + SOLID_BITMAP_WORD_BITS - 1) /
+                           SOLID_BITMAP_WORD_BITS;
+    }
+
+    // The bitmap and its words are a single allocation.
+    size_t words_size = (size_t)header.rows * header.row_words * sizeof(Uint64);
+    SolidBitmap *bitmap = xmalloc(ARENA_ALIGN(sizeof(*bitmap)) + words_size);
+    *bitmap = header;
+    bitmap->words = (Uint64 *)((char *)bitmap + ARENA_ALIGN(sizeof(*bitmap)));
+    memset(bitmap->words, 0, words_size);
+
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!level_layer_is_collidable(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            SolidBitmapCellRange range =
+                solid_bitmap_cell_range(bitmap, &tile->hitbox, false, false);
+            if (solid_bitmap_is_marked_by(tile) &&
+                solid_bitmap_clamp(bitmap, &range))
+                solid_bitmap_fill(bitmap, &range, true);
+        }
+    }
+
+    return bitmap;
+}
+
+void solid_bitmap_destroy(SolidBitmap *bitmap)
+{
+    free(bitmap);
+}
+
+bool solid_bitmap_refresh(SolidBitmap *bitmap, const VecLevelLayer layers,
+                          const SDL_FRect *area)
+{
+    SolidBitmapCellRange area_range =
+        solid_bitmap_cell_range(bitmap, area, false, false);
+    bool area_in_bitmap = solid_bitmap_clamp(bitmap, &area_range);
+
+    // The whole cells are cleared, and then every tile in them (not only the
+    // ones in the area) marks them again.
+    SDL_FRect cells = *area;
+    if (area_in_bitmap)
+    {
+        solid_bitmap_fill(bitmap, &area_range, false);
+        cells = (SDL_FRect){
+            bitmap->origin.x + area_range.first_column * bitmap->cell_size.x,
+            bitmap->origin.y + area_range.first_row * bitmap->cell_size.y,
+            (area_range.last_column - area_range.first_column + 1) *
+                bitmap->cell_size.x,
+            (area_range.last_row - area_range.first_row + 1) *
+                bitmap->cell_size.y,
+        };
+    }
+
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        LevelLayer *layer = layers[i];
+        if (!level_layer_is_collidable(layer) ||
+            (!SDL_HasIntersectionF(&layer->bounds, &cells) &&
+             !SDL_HasIntersectionF(&layer->bounds, area)))
+            continue;
+
+        vector_iter(tile, layer->tiles)
+        {
+            if (!solid_bitmap_is_marked_by(tile) ||
+                (!SDL_HasIntersectionF(&tile->hitbox, &cells) &&
+                 !SDL_HasIntersectionF(&tile->hitbox, area)))
+                continue;
+
+            SolidBitmapCellRange range =
+                solid_bitmap_cell_range(bitmap, &tile->hitbox, false, false);
+            if (!area_in_bitmap || range.first_column < 0 ||
+                range.first_row < 0 || range.last_column >= bitmap->columns ||
+                range.last_row >= bitmap->rows)
+                return false;
+
+            range.first_column =
+                SDL_max(range.first_column, area_range.first_column);
+            range.first_row = SDL_max(range.first_row, area_range.first_row);
+            range.last_column =
+                SDL_min(range.last_column, area_range.last_column);
+            range.last_row = SDL_min(range.last_row, area_range.last_row);
+            solid_bitmap_fill(bitmap, &range, true);
+        }
+    }
+
+    return true;
+}
+
+bool solid_bitmap_is_area_clear(const SolidBitmap *bitmap,
+                                const SDL_FRect *area)
+{
+    return solid_bitmap_find_first_row(bitmap, area, true) == -1;
+}
+
+int solid_bitmap_find_first_row(const SolidBitmap *bitmap,
+                                const SDL_FRect *area, bool downwards)
+{
+    SolidBitmapCellRange range =
+        solid_bitmap_cell_range(bitmap, area, false, true);
+    if (!solid_bitmap_clamp(bitmap, &range))
+        return -1;
+
+    for (int i = 0; i <= range.last_row - range.first_row; i++)
+    {
+        int row = downwards ? range.first_row + i : range.last_row - i;
+        if (solid_bitmap_row_find(bitmap, row, range.first_column,
+                                  range.last_column, true) != -1)
+            return row;
+    }
+
+    return -1;
+}
+
+int solid_bitmap_find_first_column(const SolidBitmap *bitmap,
+                                   const SDL_FRect *area, bool rightwards)
+{
+    SolidBitmapCellRange range =
+        solid_bitmap_cell_range(bitmap, area, true, false);
+    if (!solid_bitmap_clamp(bitmap, &range))
+        return -1;
+
+    // Each row narrows the span the rows after it have to search.
+    int found = -1;
+    for (int row = range.first_row; row <= range.last_row; row++)
+    {
+        int column =
+            solid_bitmap_row_find(bitmap, row, range.first_column,
+                                  range.last_column, rightwards);
+        if (column == -1)
+            continue;
+
+        found = column;
+        if (rightwards)
+            range.last_column = column;
+        else
+            range.first_column = column;
+    }
+
+    return found;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "SDL.h"
+#include "level_layer.h"
+#include <stdbool.h>
+
+/*
+ * Which cells of a level are solid, a bit per cell with all the collidable
+ * layers OR'ed together, so physics can test whole spans of cells a 64 bit
+ * word at a time instead of walking the tiles. A cell is solid if any solid
+ * tile overlaps it, so a clear cell is certainly free, while a solid one is
+ * only partly covered if the tile doesn't fill it. The cells are aligned to
+ * multiples of the cell size, and everything outside of the bitmap is clear.
+ */
+typedef struct SolidBitmap
+{
+    SDL_FPoint origin; // The top left corner of the first cell.
+    SDL_FPoint cell_size;
+    int columns, rows;
+    int row_words; // The amount of words in each row.
+    // The bits of row i are words[i * row_words..(i + 1) * row_words), the
+    // bit of column j is bit j % 64 of the row's word j / 64.
+    Uint64 *words;
+} SolidBitmap;
+
+/**
+ * @brief Builds the bitmap of the solid tiles in the collidable layers.
+ *
+ * @param layers The layers to build the bitmap from, with their current
+ *                  tiles.
+ * @param cell_size The size of a cell, ideally the size of a tile.
+ * @return The created bitmap, in a single allocation.
+ *
+ * @see solid_bitmap_destroy
+ */
+SolidBitmap *solid_bitmap_create(const VecLevelLayer layers,
+                                 SDL_FPoint cell_size);
+
+/**
+ * @brief Frees the bitmap.
+ */
+void solid_bitmap_destroy(SolidBitmap *bitmap);
+
+/**
+ * @brief Updates the cells an area overlaps from the current tiles of the
+ *          layers, after the tiles in the area were changed.
+ *
+ * @param layers The layers the bitmap was built from.
+ * @param area The area which changed, e.g. the old and the new hitbox of a
+ *              tile, one after the other.
+ * @return False if there are solid tiles in the area which fall outside of
+ *          the bitmap, in which case it has to be built again.
+ */
+bool solid_bitmap_refresh(SolidBitmap *bitmap, const VecLevelLayer layers,
+                          const SDL_FRect *area);
+
+/**
+ * @brief Checks if there are no solid cells in the cells the area overlaps,
+ *          or only touches from above or below.
+ */
+bool solid_bitmap_is_area_clear(const SolidBitmap *bitmap,
+                                const SDL_FRect *area);
+
+/**
+ * @brief Finds the first row with a solid cell among the cells the area
+ *          overlaps, going down or up through the area. The rows it only
+ *          touches count, as it's how far a body moves, but not the columns,
+ *          as a body only brushes past those.
+ *
+ * @param downwards Whether to start from the top of the area.
+ * @return The row, or -1 if the area is clear.
+ */
+int solid_bitmap_find_first_row(const SolidBitmap *bitmap,
+                                const SDL_FRect *area, bool downwards);
+
+/**
+ * @brief Finds the first column with a solid cell among the cells the area
+ *          overlaps, going right or left through the area. The columns it
+ *          only touches count, but not the rows, so a body walking on the
+ *          floor doesn't find it in its way.
+ *
+ * @param rightwards Whether to start from the left of the area.
+ * @return The column, or -1 if the area is clear.
+ */
+int solid_bitmap_find_first_column(const SolidBitmap *bitmap,
+                                   const SDL_FRect *area, bool rightwards);
@@ -0,0 +1,369 @@
+#include "SDL.h"
+#include "spatial_hash.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdbool.h>
+#include <string.h>
+
+// The least amount of objects the pool grows to.
+#define SPATIAL_HASH_MIN_OBJECTS 64
+
+// What a query is looking for: the objects which can match have their center
+// in the cells bounds overlaps, and they match if they are in the area, or
+// within the radius of the center.
+typedef struct SpatialHashQuery
+{
+    SDL_FRect bounds;
+    SDL_FRect area;
+    SDL_FPoint center;
+    float radius;
+    bool is_radius;
+} SpatialHashQuery;
+
+static Uint32 spatial_hash_cell_hash(int column, int row)
+{
+    Uint32 hash = (Uint32)column * 0x9E3779B1u ^ (Uint32)row * 0x85EBCA77u;
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6Du;
+    hash ^= hash >> 12;
+
+    return hash;
+}
+
+/**
+ * @brief Finds the slot of a cell, or the free slot it would go in. The table
+ *          is never more than half full, so there always is one.
+ */
+static SpatialHashSlot *spatial_hash_find_slot(const SpatialHash *hash,
+                                               int column, int row)
+{
+    size_t mask = hash->slot_count - 1;
+    for (size_t i = spatial_hash_cell_hash(column, row) & mask;;
+         i = (i + 1) & mask)
+    {
+        SpatialHashSlot *slot = &hash->slots[i];
+        if (!slot->occupied || (slot->column == column && slot->row == row))
+            return slot;
+    }
+}
+
+/**
+ * @brief Allocates a table of free slots.
+ */
+static void spatial_hash_alloc_slots(SpatialHash *hash, size_t slot_count)
+{
+    hash->slots = xmalloc(slot_count * sizeof(*hash->slots));
+    memset(hash->slots, 0, slot_count * sizeof(*hash->slots));
+    hash->slot_count = slot_count;
+    hash->occupied_slots = 0;
+}
+
+/**
+ * @brief Builds the table again, without the cells which became empty, and
+ *          with room for at least as many cells as are left.
+ */
+static void spatial_hash_rehash(SpatialHash *hash)
+{
+    SpatialHashSlot *old_slots = hash->slots;
+    size_t old_slot_count = hash->slot_count;
+
+    size_t cell_count = 0;
+    for (size_t i = 0; i < old_slot_count; i++)
+    {
+        cell_count += old_slots[i].occupied &&
+                      old_slots[i].first != SPATIAL_HASH_NONE;
+    }
+
+    size_t slot_count = SPATIAL_HASH_MIN_SLOTS;
+    while (slot_count < 4 * (cell_count + 1))
+        slot_count *= 2;
+    spatial_hash_alloc_slots(hash, slot_count);
+
+    for (size_t i = 0; i < old_slot_count; i++)
+    {
+        const SpatialHashSlot *old_slot = &old_slots[i];
+        if (!old_slot->occupied || old_slot->first == SPATIAL_HASH_NONE)
+            continue;
+
+        *spatial_hash_find_slot(hash, old_slot->column, old_slot->row) =
+            *old_slot;
+        hash->occupied_slots++;
+    }
+
+    free(old_slots);
+}
+
+/**
+ * @brief Gets the slot of a cell, adding the cell if it isn't in the table.
+ *
+ * @warning Adding a cell might rebuild the table, which moves the slots.
+ */
+static SpatialHashSlot *spatial_hash_get_cell(SpatialHash *hash, int column,
+                                              int row)
+{
+    SpatialHashSlot *slot = spatial_hash_find_slot(hash, column, row);
+    if (slot->occupied)
+        return slot;
+
+    // Empty cells keep their slots until the table is rebuilt.
+    if (2 * (hash->occupied_slots + 1) > hash->slot_count)
+    {
+        spatial_hash_rehash(hash);
+        slot = spatial_hash_find_slot(hash, column, row);
+    }
+
+    *slot = (SpatialHashSlot){
+        .column = column,
+        .row = row,
+        .first = SPATIAL_HASH_NONE,
+        .occupied = true,
+    };
+    hash->occupied_slots++;
+
+    return slot;
+}
+
+/**
+ * @brief Sets the cell of the object to the one its center is in.
+ */
+static void spatial_hash_place(const SpatialHash *hash,
+                               SpatialHashObject *object)
+{
+    object->column = (int)SDL_floorf((object->box.x + object->box.w / 2) /
+                                     hash->cell_size.x);
+    object->row = (int)SDL_floorf((object->box.y + object->box.h / 2) /
+                                  hash->cell_size.y);
+}
+
+/**
+ * @brief Adds the object to the front of the list of its cell.
+ */
+static void spatial_hash_link(SpatialHash *hash, SpatialHashHandle handle)
+{
+    SpatialHashObject *object = &hash->objects[handle];
+    SpatialHashSlot *cell =
+        spatial_hash_get_cell(hash, object->column, object->row);
+
+    object->prev = SPATIAL_HASH_NONE;
+    object->next = cell->first;
+    if (cell->first != SPATIAL_HASH_NONE)
+        hash->objects[cell->first].prev = handle;
+    cell->first = handle;
+}
+
+/**
+ * @brief Takes the object out of the list of its cell.
+ */
+static void spatial_hash_unlink(SpatialHash *hash, SpatialHashHandle handle)
+{
+    SpatialHashObject *object = &hash->objects[handle];
+    if (object->prev != SPATIAL_HASH_NONE)
+    {
+        hash->objects[object->prev].next = object->next;
+    }
+    else
+    {
+        spatial_hash_find_slot(hash, object->column, object->row)->first =
+            object->next;
+    }
+
+    if (object->next != SPATIAL_HASH_NONE)
+        hash->objects[object->next].prev = object->prev;
+}
+
+/**
+ * @brief Grows the largest object size to cover the box.
+ */
+static void spatial_hash_fit(SpatialHash *hash, const SDL_FRect *box)
+{
+    hash->max_object_size.x = SDL_max(hash->max_object_size.x, box->w);
+    hash->max_object_size.y = SDL_max(hash->max_object_size.y, box->h);
+}
+
+SpatialHash *spatial_hash_create(SDL_FPoint cell_size)
+{
+    SpatialHash *hash = xmalloc(sizeof(*hash));
+    hash->cell_size = cell_size;
+    hash->max_object_size = (SDL_FPoint){0, 0};
+    spatial_hash_alloc_slots(hash, SPATIAL_HASH_MIN_SLOTS);
+    hash->objects = NULL;
+    hash->object_capacity = 0;
+    hash->objects_used = 0;
+    hash->free_list = SPATIAL_HASH_NONE;
+
+    return hash;
+}
+
+void spatial_hash_destroy(SpatialHash *hash)
+{
+    free(hash->objects);
+    free(hash->slots);
+    free(hash);
+}
+
+SpatialHashHandle spatial_hash_insert(SpatialHash *hash, SDL_FRect box,
+                                      void *data)
+{
+    SpatialHashHandle handle = hash->free_list;
+    if (handle != SPATIAL_HASH_NONE)
+    {
+        hash->free_list = hash->objects[handle].next;
+    }
+    else
+    {
+        if (hash->objects_used == hash->object_capacity)
+        {
+            hash->object_capacity =
+                SDL_max(2 * hash->object_capacity, SPATIAL_HASH_MIN_OBJECTS);
+            hash->objects = xrealloc(hash->objects, hash->object_capacity *
+                                                        sizeof(*hash->objects));
+        }
+        handle = hash->objects_used++;
+    }
+
+    SpatialHashObject *object = &hash->objects[handle];
+    object->box = box;
+    object->data = data;
+    spatial_hash_place(hash, object);
+    spatial_hash_fit(hash, &box);
+    spatial_hash_link(hash, handle);
+
+    return handle;
+}
+
+void spatial_hash_move(SpatialHash *hash, SpatialHashHandle handle,
+                       SDL_FRect box)
+{
+    SpatialHashObject *object = &hash->objects[handle];
+    SpatialHashObject moved = {.box = box};
+    spatial_hash_place(hash, &moved);
+
+    object->box = box;
+    spatial_hash_fit(hash, &box);
+    if (moved.column == object->column && moved.row == object->row)
+        return;
+
+    spatial_hash_unlink(hash, handle);
+    object->column = moved.column;
+    object->row = moved.row;
+    spatial_hash_link(hash, handle);
+}
+
+void spatial_hash_remove(SpatialHash *hash, SpatialHashHandle handle)
+{
+    spatial_hash_unlink(hash, handle);
+
+    SpatialHashObject *object = &hash->objects[handle];
+    object->data = NULL;
+    object->next = hash->free_list;
+    hash->free_list = handle;
+}
+
+const SpatialHashObject *spatial_hash_get(const SpatialHash *hash,
+                                          SpatialHashHandle handle)
+{
+    return &hash->objects[handle];
+}
+
+static bool spatial_hash_query_matches(const SpatialHashQuery *query,
+                                       const SpatialHashObject *object)
+{
+    if (!query->is_radius)
+        return SDL_HasIntersectionF(&object->box, &query->area);
+
+    // The distance to the closest point of the box.
+    const SDL_FRect *box = &object->box;
+    float dx = SDL_max(SDL_max(box->x - query->center.x,
+                               query->center.x - (box->x + box->w)),
+                       0);
+    float dy = SDL_max(SDL_max(box->y - query->center.y,
+                               query->center.y - (box->y + box->h)),
+                       0);
+    return dx * dx + dy * dy <= query->radius * query->radius;
+}
+
+static void spatial_hash_query_cell(const SpatialHash *hash,
+                                    const SpatialHashSlot *cell,
+                                    const SpatialHashQuery *query,
+                                    VecSpatialHashHandle *found)
+{
+    for (SpatialHashHandle handle = cell->first; handle != SPATIAL_HASH_NONE;
+         handle = hash->objects[handle].next)
+    {
+        if (spatial_hash_query_matches(query, &hash->objects[handle]))
+            vector_add(found, handle);
+    }
+}
+
+/**
+ * @brief Finds the objects matching the query, from the cells the bounds of
+ *          the query overlap. If there are more of those than cells in the
+ *          table, the table is scanned instead.
+ */
+static void spatial_hash_query(const SpatialHash *hash,
+                               const SpatialHashQuery *query,
+                               VecSpatialHashHandle *found)
+{
+    // An object can match while its center is up to half its size away.
+    SDL_FRect bounds = query->bounds;
+    bounds.x -= hash->max_object_size.x / 2;
+    bounds.y -= hash->max_object_size.y / 2;
+    bounds.w += hash->max_object_size.x;
+    bounds.h += hash->max_object_size.y;
+
+    float first_column = SDL_floorf(bounds.x / hash->cell_size.x);
+    float first_row = SDL_floorf(bounds.y / hash->cell_size.y);
+    float last_column = SDL_floorf((bounds.x + bounds.w) / hash->cell_size.x);
+    float last_row = SDL_floorf((bounds.y + bounds.h) / hash->cell_size.y);
+
+    double cell_count = ((double)last_column - first_column + 1) *
+                        ((double)last_row - first_row + 1);
+    if (cell_count > hash->occupied_slots)
+    {
+        for (size_t i = 0; i < hash->slot_count; i++)
+        {
+            const SpatialHashSlot *slot = &hash->slots[i];
+            if (slot->occupied && slot->column >= first_column &&
+                slot->column <= last_column && slot->row >= first_row &&
+                slot->row <= last_row)
+                spatial_hash_query_cell(hash, slot, query, found);
+        }
+        return;
+    }
+
+    for (int row = (int)first_row; row <= (int)last_row; row++)
+    {
+        for (int column = (int)first_column; column <= (int)last_column;
+             column++)
+        {
+            const SpatialHashSlot *slot =
+                spatial_hash_find_slot(hash, column, row);
+            if (slot->occupied)
+                spatial_hash_query_cell(hash, slot, query, found);
+        }
+    }
+}
+
+void spatial_hash_query_rect(const SpatialHash *hash, const SDL_FRect *area,
+                             VecSpatialHashHandle *found)
+{
+    SpatialHashQuery query = {
+        .bounds = *area,
+        .area = *area,
+        .is_radius = false,
+    };
+    spatial_hash_query(hash, &query, found);
+}
+
+void spatial_hash_query_radius(const SpatialHash *hash, SDL_FPoint center,
+                               float radius, VecSpatialHashHandle *found)
+{
+    SpatialHashQuery query = {
+        .bounds = {center.x - radius, center.y - radius, 2 * radius,
+                   2 * radius},
+        .center = center,
+        .radius = radius,
+        .is_radius = true,
+    };
+    spatial_hash_query(hash, &query, found);
+}
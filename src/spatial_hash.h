@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SDL.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Identifies an object in a spatial hash, stable until the object is removed.
+typedef Uint32 SpatialHashHandle;
+
+typedef SpatialHashHandle *VecSpatialHashHandle;
+
+// No object, the end of a list.
+#define SPATIAL_HASH_NONE ((SpatialHashHandle)-1)
+
+// The least amount of slots of the cell table.
+#define SPATIAL_HASH_MIN_SLOTS 64
+
+// An object in the pool. Each one is in the list of the cell its center is
+// in, or in the free list once removed.
+typedef struct SpatialHashObject
+{
+    SDL_FRect box;
+    void *data;
+    int column, row;             // The cell it's in.
+    SpatialHashHandle prev, next; // Its neighbours in the cell's list.
+} SpatialHashObject;
+
+// A slot of the cell table.
+typedef struct SpatialHashSlot
+{
+    int column, row;
+    SpatialHashHandle first; // SPATIAL_HASH_NONE if the cell is empty.
+    bool occupied;           // Whether the slot holds a cell.
+} SpatialHashSlot;
+
+/*
+ * An index of moving objects (items, enemies, lights), for the "what's near
+ * me" queries of callbacks, AI and lighting, where the tile grid only holds
+ * the static tiles. Space is split into cells, and only the cells which hold
+ * objects are in the table, an open addressing one keyed by the cell's
+ * coordinates, so the index covers unbounded space. Each cell heads an
+ * intrusive list of the objects whose center is in it, all allocated from a
+ * single pool. Inserting, moving and removing an object take O(1).
+ */
+typedef struct SpatialHash
+{
+    SDL_FPoint cell_size;
+    // The largest size of any object ever in the hash, which is how far out
+    // of its cell an object can reach.
+    SDL_FPoint max_object_size;
+
+    SpatialHashSlot *slots;
+    size_t slot_count; // A power of 2.
+    size_t occupied_slots;
+
+    // The pool, objects[0..objects_used) were handed out at some point, and
+    // the removed ones among them are in the free list.
+    SpatialHashObject *objects;
+    size_t object_capacity;
+    size_t objects_used;
+    SpatialHashHandle free_list;
+} SpatialHash;
+
+/**
+ * @brief Creates an empty spatial hash.
+ *
+ * @param cell_size The size of a cell, ideally about that of the objects.
+ * @return The created spatial hash.
+ *
+ * @see spatial_hash_destroy
+ */
+SpatialHash *spatial_hash_create(SDL_FPoint cell_size);
+
+/**
+ * @brief Frees the spatial hash and its pool.
+ */
+void spatial_hash_destroy(SpatialHash *hash);
+
+/**
+ * @brief Inserts an object.
+ *
+ * @param box The object's hitbox.
+ * @param data What the object stands for, given back with it.
+ * @return The handle of the object.
+ */
+SpatialHashHandle spatial_hash_insert(SpatialHash *hash, SDL_FRect box,
+                                      void *data);
+
+/**
+ * @brief Moves an object to its new hitbox. If its center stays in the same
+ *          cell, only the hitbox is updated in place.
+ */
+void spatial_hash_move(SpatialHash *hash, SpatialHashHandle handle,
+                       SDL_FRect box);
+
+/**
+ * @brief Removes an object. Its handle may be reused by a later insert.
+ */
+void spatial_hash_remove(SpatialHash *hash, SpatialHashHandle handle);
+
+/**
+ * @brief Gets an object of the hash.
+ */
+const SpatialHashObject *spatial_hash_get(const SpatialHash *hash,
+                                          SpatialHashHandle handle);
+
+/**
+ * @brief Finds the objects whose hitbox overlaps the area, as
+ *          SDL_HasIntersectionF.
+ *
+ * @param[out] found The handles of the objects are added to this vector.
+ */
+void spatial_hash_query_rect(const SpatialHash *hash, const SDL_FRect *area,
+                             VecSpatialHashHandle *found);
+
+/**
+ * @brief Finds the objects whose hitbox is within the radius of a point (or
+ *          touches the circle).
+ *
+ * @param[out] found The handles of the objects are added to this vector.
+ */
+void spatial_hash_query_radius(const SpatialHash *hash, SDL_FPoint center,
+                               float radius, VecSpatialHashHandle *found);
@@ -32,3 +32,13 @@ void tile_init(Tile *tile, SDL_FRect hitbox, SDL_Texture *texture,
     tile->solid = solid;
     tile->callback = callback;
 }
+
+bool tile_is_solid(const Tile *tile)
+{
+    return tile->solid;
+}
+
+bool tile_is_trigger(const Tile *tile)
+{
+    return tile->callback.func && tile->callback.func != tile_callback_none;
+}
@@ -33,6 +33,16 @@ void tile_init(Tile *tile, SDL_FRect hitbox, SDL_Texture *texture,
 
 // There is no clean-up as there is no memory managed by the tile.
 
+/**
+ * @brief Checks if the tile is solid.
+ */
+bool tile_is_solid(const Tile *tile);
+
+/**
+ * @brief Checks if the tile is a trigger, i.e. it has a callback.
+ */
+bool tile_is_trigger(const Tile *tile);
+
 /**
  * @brief Draws the tile.
  *
@@ -1,24 +1,28 @@
 #include "SDL.h"
 #include "character.h"
 #include "hashmap.h"
+#include "intern.h"
 #include "level.h"
+#include "level_catalog.h"
 #include "string.h"
 #include "tile_callback.h"
 #include "utils.h"
 #include "vec.h"
 #include <stdlib.h>
 
-typedef HASHMAP(char, TileCallbackInfo) TileCallbackHashmap;
+typedef HASHMAP(HashedString, TileCallbackInfo) TileCallbackHashmap;
 
 static TileCallbackHashmap tile_callbacks;
 
 TileCallbackInfo *tile_callback_info_create(const char *name,
                                             TileCallbackType type,
+                                            TileCallbackTriggers triggers,
                                             TileCallbackFunction callback)
 {
     TileCallbackInfo *info = xmalloc(sizeof(TileCallbackInfo));
-    info->name = strdup(name);
+    info->name = intern_cstr(name);
     info->type = type;
+    info->triggers = triggers;
     info->callback = callback;
 
     return info;
@@ -26,29 +30,33 @@ TileCallbackInfo *tile_callback_info_create(const char *name,
 
 void tile_callback_info_destroy(TileCallbackInfo *info)
 {
-    free(info->name);
     free(info);
 }
 
 void tile_callback_add(const char *name, TileCallbackType type,
+                       TileCallbackTriggers triggers,
                        TileCallbackFunction callback)
 {
-    TileCallbackInfo *info = tile_callback_info_create(name, type, callback);
+    TileCallbackInfo *info =
+        tile_callback_info_create(name, type, triggers, callback);
 
     hashmap_put(&tile_callbacks, info->name, info);
 }
 
 void tile_callback_init()
 {
-    hashmap_init(&tile_callbacks, hashmap_hash_string, strcmp);
+    hashmap_init(&tile_callbacks, interned_string_hash,
+                 interned_string_compare);
 
-    tile_callback_add("", TILE_CALLBACK_NONE, tile_callback_none);
-    tile_callback_add("ladder", TILE_CALLBACK_LADDER, tile_callback_ladder);
+    tile_callback_add("", TILE_CALLBACK_NONE, 0, tile_callback_none);
+    tile_callback_add("ladder", TILE_CALLBACK_LADDER,
+                      TILE_CALLBACK_TRIGGER(TILE_EVENT_KEY),
+                      tile_callback_ladder);
 }
 
 void tile_callback_cleanup()
 {
-    const char *key;
+    const HashedString *key;
     void *temp;
 
     hashmap_foreach_key_safe(key, &tile_callbacks, temp)
@@ -60,9 +68,14 @@ void tile_callback_cleanup()
     hashmap_cleanup(&tile_callbacks);
 }
 
-const TileCallbackInfo *tile_callback_get(const char *name)
+const TileCallbackInfo *tile_callback_get(const char *name, size_t len)
 {
-    return hashmap_get(&tile_callbacks, name);
+    // A name which was never interned can't be the name of a callback.
+    InternedString key = intern_find(name, len);
+    if (!key)
+        return NULL;
+
+    return hashmap_get(&tile_callbacks, key);
 }
 
 void tile_callback_ladder(TileArguments *args, CallbackGameState *game_state)
@@ -71,33 +84,27 @@ void tile_callback_ladder(TileArguments *args, CallbackGameState *game_state)
 
     Level *level = *game_state->level_ptr;
 
-    SDL_FRect *character_hitbox = &game_state->character->hitbox;
+    SDL_FRect character_hitbox = character_get_hitbox(game_state->character);
 
     if (!level_check_for_collision(level, game_state->tile_texture_id,
-                                   character_hitbox))
+                                   &character_hitbox))
         return;
 
-    size_t level_amount = hashmap_size(game_state->levels);
+    // The current level is not one of the options.
+    Level *next_level = level_catalog_pick_other(game_state->level_catalog,
+                                                 level, game_state->rng);
 
     // TODO: in this case, we want to set to the final level or to level
     //       crossing.
-    SDL_assert(level_amount > 0 && "Not supported yet.");
-
-    size_t level_idx = rand() % level_amount;
+    SDL_assert(next_level != NULL && "Not supported yet.");
+    if (!next_level)
+        return;
 
-    const char *level_name;
-    hashmap_foreach_key(level_name, game_state->levels)
-    {
-        if (level_idx != 0)
-        {
-            level_idx--;
-            continue;
-        }
-
-        level_select(game_state->level_ptr, game_state->levels, level_name,
-                     &game_state->character->hitbox);
-        break;
-    }
+    SDL_FPoint character_position =
+        character_get_position(game_state->character);
+    level_select(game_state->level_ptr, game_state->levels, next_level->name,
+                 &character_position);
+    character_set_position(game_state->character, character_position);
 }
 
 void tile_callback_none(TileArguments *, CallbackGameState *)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SDL_keycode.h"
+#include "intern.h"
 
 typedef enum TileCallbackType
 {
@@ -19,12 +20,31 @@ typedef union TileArguments
     struct TileCallbackLadderArgument ladder;
 } TileArguments;
 
+typedef enum TileEventType
+{
+    TILE_EVENT_KEY,   // A key the tile is subscribed to was pressed.
+    TILE_EVENT_ENTER, // The character started overlapping the tile.
+    TILE_EVENT_STAY,  // The character kept overlapping the tile.
+    TILE_EVENT_EXIT,  // The character stopped overlapping the tile.
+} TileEventType;
+
+// The events a callback is called for, a bit per TileEventType. Key events
+// come from the keymap, so only the overlap events are filtered by these.
+typedef Uint8 TileCallbackTriggers;
+
+#define TILE_CALLBACK_TRIGGER(event_type)                                      \
+    ((TileCallbackTriggers)(1 << (event_type)))
+
 typedef struct CallbackGameState
 {
     struct Character *character;
     struct LevelHashmap *levels;
     struct Level **level_ptr;
-    SDL_Keycode key;     // Key that triggered the call
+    struct LevelCatalog *level_catalog; // For picking levels at random.
+    struct Rng *rng; // Every random choice is drawn from it.
+    struct Arena *frame_arena; // For transient data, reset every frame.
+    TileEventType event; // The event that triggered the call
+    SDL_Keycode key;     // Key that triggered the call, for key events
     int tile_texture_id; // The id of the tile for the event
 } CallbackGameState;
 
@@ -33,8 +53,9 @@ typedef void (*TileCallbackFunction)(TileArguments *args,
 
 typedef struct TileCallbackInfo
 {
-    char *name;
+    InternedString name;
     TileCallbackType type;
+    TileCallbackTriggers triggers;
     TileCallbackFunction callback;
 } TileCallbackInfo;
 
@@ -42,6 +63,7 @@ typedef struct TileCallback
 {
     TileCallbackFunction func;
     TileArguments *args;
+    TileCallbackTriggers triggers;
     int id; // The id of the tile
 } TileCallback;
 
@@ -66,15 +88,17 @@ void tile_callback_args_cleanup(TileArguments *args);
 /**
  * @brief Gets the tile callback function with the given name.
  *
- * @param name The name of the callback.
- * @return The callback function and it's type.
+ * @param name The name of the callback, doesn't have to be null terminated.
+ * @param len The length of the name.
+ * @return The callback function and it's type, or NULL if there is no
+ *          callback with the given name.
  * @warning Do not free the returned pointer.
  *
  * @warning Always initialize the tile callbacks before using.
  * @see tile_callback_init
  * @see tile_callback_cleanup
  */
-const TileCallbackInfo *tile_callback_get(const char *name);
+const TileCallbackInfo *tile_callback_get(const char *name, size_t len);
 
 /**
  * @brief Called when a ladder event is triggered
@@ -0,0 +1,252 @@
+#define ALLOC_TAG ALLOC_TAG_LEVEL
+
+#include "SDL.h"
+#include "arena.h"
+#include "tile_grid.h"
+#include "utils.h"
+#include "vec.h"
+#include <string.h>
+
+bool tile_grid_cell_range(const TileGrid *grid, const SDL_FRect *rect,
+                          TileGridCellRange *range)
+{
+    float left = (rect->x - grid->origin.x) / grid->cell_size.x;
+    float top = (rect->y - grid->origin.y) / grid->cell_size.y;
+    float right = left + rect->w / grid->cell_size.x;
+    float bottom = top + rect->h / grid->cell_size.y;
+
+    if (right < 0 || bottom < 0 || left >= grid->columns || top >= grid->rows)
+        return false;
+
+    range->first_column = SDL_max((int)SDL_floorf(left), 0);
+    range->first_row = SDL_max((int)SDL_floorf(top), 0);
+    range->last_column = SDL_min((int)SDL_floorf(right), grid->columns - 1);
+    range->last_row = SDL_min((int)SDL_floorf(bottom), grid->rows - 1);
+
+    return true;
+}
+
+/**
+ * @brief Checks if the grid indexes the tiles of the layer. A layer with a
+ *          parallax other than 1 is drawn away from its tiles, so what is seen
+ *          of it wouldn't be what is collided with.
+ */
+static bool tile_grid_indexes_layer(const LevelLayer *layer)
+{
+    return layer->properties.parallax == 1;
+}
+
+/**
+ * @brief Sizes the grid so that it covers all the tiles passing the filter.
+ *
+ * @return The amount of entries the grid needs.
+ */
+static size_t tile_grid_fit(TileGrid *grid, const VecLevelLayer layers,
+                            TileGridFilter filter)
+{
+    float min_x = INFINITY, min_y = INFINITY;
+    float max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!tile_grid_indexes_layer(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            if (!filter(tile))
+                continue;
+
+            min_x = SDL_min(min_x, tile->hitbox.x);
+            min_y = SDL_min(min_y, tile->hitbox.y);
+            max_x = SDL_max(max_x, tile->hitbox.x + tile->hitbox.w);
+            max_y = SDL_max(max_y, tile->hitbox.y + tile->hitbox.h);
+        }
+    }
+
+    grid->columns = grid->rows = 0;
+    if (min_x == INFINITY) // No tiles to index.
+        return 0;
+
+    grid->origin = (SDL_FPoint){min_x, min_y};
+    grid->columns = (int)SDL_floorf((max_x - min_x) / grid->cell_size.x) + 1;
+    grid->rows = (int)SDL_floorf((max_y - min_y) / grid->cell_size.y) + 1;
+
+    size_t entry_count = 0;
+    for (size_t i = 0; i < vector_size(layers); i++)
+    {
+        if (!tile_grid_indexes_layer(layers[i]))
+            continue;
+
+        vector_iter(tile, layers[i]->tiles)
+        {
+            TileGridCellRange range;
+            if (!filter(tile) ||
+                !tile_grid_cell_range(grid, &tile->hitbox, &range))
+                continue;
+
+            entry_count +=
+                (size_t)(range.last_column - range.first_column + 1) *
+                (range.last_row - range.first_row + 1);
+        }
+    }
+
+    return entry_count;
+}
+
+TileGrid *tile_grid_create(const VecLevelLayer layers, SDL_FPoint cell_size,
+                           TileGridFilter filter)
+{
+    TileGrid grid_header = {.cell_size = cell_size};
+    size_t entry_count = tile_grid_fit(&grid_header, layers, filter);
+    size_t cell_count = (size_t)grid_header.columns * grid_header.rows;
+
+    // The grid, its offsets and its entries are a single allocation.
+    size_t offsets_size = (cell_count + 1) * sizeof(Uint32);
+    TileGrid *grid =
+        xmalloc(ARENA_ALIGN(sizeof(*grid)) + ARENA_ALIGN(offsets_size) +
+                entry_count * sizeof(TileGridEntry));
+    *grid = grid_header;
+    grid->cell_offsets = (Uint32 *)((char *)grid + ARENA_ALIGN(sizeof(*grid)));
+    grid->entries = (TileGridEntry *)((char *)grid->cell_offsets +
+                                      ARENA_ALIGN(offsets_size));
+    memset(grid->cell_offsets, 0, offsets_size);
+
+    /* Every cell's entries are counted one slot ahead, so the prefix sum
+     * gives the start offsets. The offsets are then used as cursors while
+     * placing the entries, which moves each one to the start of the next
+     * cell, so they are shifted back after. */
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (size_t i = 0; i < vector_size(layers); i++)
+        {
+            if (!tile_grid_indexes_layer(layers[i]))
+                continue;
+
+            for (size_t j = 0; j < vector_size(layers[i]->tiles); j++)
+            {
+                const Tile *tile = &layers[i]->tiles[j];
+                TileGridCellRange range;
+                if (!filter(tile) ||
+                    !tile_grid_cell_range(grid, &tile->hitbox, &range))
+                    continue;
+
+                for (int row = range.first_row; row <= range.last_row; row++)
+                {
+                    for (int column = range.first_column;
+                         column <= range.last_column; column++)
+                    {
+                        size_t cell = (size_t)row * grid->columns + column;
+                        if (pass == 0)
+                        {
+                            grid->cell_offsets[cell + 1]++;
+                            continue;
+                        }
+
+                        Uint8 flags = 0;
+                        if (column == range.first_column)
+                            flags |= TILE_GRID_ENTRY_FIRST_COLUMN;
+                        if (row == range.first_row)
+                            flags |= TILE_GRID_ENTRY_FIRST_ROW;
+
+                        grid->entries[grid->cell_offsets[cell]++] =
+                            (TileGridEntry){
+                                .texture_id = tile->texture_id,
+                                .tile = j,
+                                .layer = i,
+                                .flags = flags,
+                            };
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            for (size_t cell = 1; cell <= cell_count; cell++)
+            {
+                grid->cell_offsets[cell] += grid->cell_offsets[cell - 1];
+            }
+        }
+    }
+
+    for (size_t cell = cell_count; cell > 0; cell--)
+    {
+        grid->cell_offsets[cell] = grid->cell_offsets[cell - 1];
+    }
+    grid->cell_offsets[0] = 0;
+
+    return grid;
+}
+
+void tile_grid_destroy(TileGrid *grid)
+{
+    free(grid);
+}
+
+bool tile_grid_check_for_collision(const TileGrid *grid,
+                                   const VecLevelLayer layers, int target_id,
+                                   const SDL_FRect *hitbox)
+{
+    TileGridCellRange range;
+    if (!tile_grid_cell_range(grid, hitbox, &range))
+        return false;
+
+    for (int row = range.first_row; row <= range.last_row; row++)
+    {
+        for (int column = range.first_column; column <= range.last_column;
+             column++)
+        {
+            size_t cell = (size_t)row * grid->columns + column;
+            for (Uint32 i = grid->cell_offsets[cell];
+                 i < grid->cell_offsets[cell + 1]; i++)
+            {
+                const TileGridEntry *entry = &grid->entries[i];
+                if (entry->texture_id != target_id)
+                    continue;
+
+                const Tile *tile = &layers[entry->layer]->tiles[entry->tile];
+                if (SDL_HasIntersectionF(hitbox, &tile->hitbox))
+                    return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void tile_grid_find_collisions(const TileGrid *grid,
+                               const VecLevelLayer layers,
+                               const SDL_FRect *hitbox,
+                               VecTileGridEntry *collisions)
+{
+    TileGridCellRange range;
+    if (!tile_grid_cell_range(grid, hitbox, &range))
+        return;
+
+    for (int row = range.first_row; row <= range.last_row; row++)
+    {
+        for (int column = range.first_column; column <= range.last_column;
+             column++)
+        {
+            size_t cell = (size_t)row * grid->columns + column;
+            for (Uint32 i = grid->cell_offsets[cell];
+                 i < grid->cell_offsets[cell + 1]; i++)
+            {
+                const TileGridEntry *entry = &grid->entries[i];
+                const Tile *tile = &layers[entry->layer]->tiles[entry->tile];
+
+                /* A tile spanning several cells is only reported from the
+                 * first cell both it and the hitbox overlap, which is the
+                 * first row and column of either of them. */
+                if ((row != range.first_row &&
+                     !(entry->flags & TILE_GRID_ENTRY_FIRST_ROW)) ||
+                    (column != range.first_column &&
+                     !(entry->flags & TILE_GRID_ENTRY_FIRST_COLUMN)))
+                    continue;
+
+                if (SDL_HasIntersectionF(hitbox, &tile->hitbox))
+                    vector_add(collisions, *entry);
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "SDL.h"
+#include "level_layer.h"
+#include "tile.h"
+#include <stdbool.h>
+
+// Set on the entries in the first column or row a tile overlaps.
+#define TILE_GRID_ENTRY_FIRST_COLUMN (Uint8)0x01
+#define TILE_GRID_ENTRY_FIRST_ROW (Uint8)0x02
+
+// The tile a grid entry refers to, as indices into the layers it was built
+// from, so it stays valid when the layer's tiles are copied on write.
+typedef struct TileGridEntry
+{
+    int texture_id; // Copied from the tile, so filtering doesn't touch it.
+    Uint32 tile;
+    Uint16 layer;
+    Uint8 flags;
+} TileGridEntry;
+
+typedef TileGridEntry *VecTileGridEntry;
+
+// The cells a rectangle overlaps, inclusive.
+typedef struct TileGridCellRange
+{
+    int first_column, last_column;
+    int first_row, last_row;
+} TileGridCellRange;
+
+// Selects the tiles a grid is built over.
+typedef bool (*TileGridFilter)(const Tile *tile);
+
+/*
+ * A uniform grid over some of the tiles of a level (e.g. the triggers or the
+ * solid tiles), so the tiles near a hitbox can be found without scanning the
+ * level. The entries of each cell are contiguous, and a tile is in every cell
+ * its hitbox overlaps. Layers with a parallax other than 1 are left out, as
+ * their tiles aren't drawn where they are. The grid is immutable once built.
+ */
+typedef struct TileGrid
+{
+    SDL_FPoint origin; // The top left corner of the first cell.
+    SDL_FPoint cell_size;
+    int columns, rows;
+    // The entries of cell i are entries[cell_offsets[i]..cell_offsets[i + 1]).
+    Uint32 *cell_offsets;
+    TileGridEntry *entries;
+} TileGrid;
+
+/**
+ * @brief Builds a grid over the tiles in the layers which pass the filter,
+ *          skipping the layers with a parallax other than 1.
+ *
+ * @param layers The layers to index, the grid refers to the tiles by their
+ *                  index. Built from the tiles as they were loaded.
+ * @param cell_size The size of a cell, ideally the size of a tile.
+ * @param filter Selects the tiles to index, e.g. tile_is_trigger.
+ * @return The created grid, in a single allocation.
+ *
+ * @see tile_grid_destroy
+ */
+TileGrid *tile_grid_create(const VecLevelLayer layers, SDL_FPoint cell_size,
+                           TileGridFilter filter);
+
+/**
+ * @brief Frees the grid.
+ */
+void tile_grid_destroy(TileGrid *grid);
+
+/**
+ * @brief Finds the cells the rectangle overlaps (or touches), clamped to the
+ *          grid. The entries of cell (column, row) are those at
+ *          cell_offsets[row * columns + column].
+ *
+ * @param[out] range The cells.
+ * @return False if the rectangle is outside of the grid.
+ */
+bool tile_grid_cell_range(const TileGrid *grid, const SDL_FRect *rect,
+                          TileGridCellRange *range);
+
+/**
+ * @brief Checks for collision between the indexed tiles with the given id
+ *          which are near the hitbox and the hitbox.
+ *
+ * @param layers The layers the grid was built from.
+ * @param target_id The texture id of the tiles to check for collision.
+ * @param hitbox The hitbox to check for collision.
+ * @return True if there is collision, false otherwise.
+ */
+bool tile_grid_check_for_collision(const TileGrid *grid,
+                                   const VecLevelLayer layers, int target_id,
+                                   const SDL_FRect *hitbox);
+
+/**
+ * @brief Finds all the indexed tiles which collide with the hitbox. Each tile
+ *          is found once, even if it spans several cells.
+ *
+ * @param layers The layers the grid was built from.
+ * @param hitbox The hitbox to find the collisions with.
+ * @param[out] collisions Vector the entries of the colliding tiles are added
+ *                          to. The entries identify the tiles across frames,
+ *                          unlike pointers to them.
+ */
+void tile_grid_find_collisions(const TileGrid *grid,
+                               const VecLevelLayer layers,
+                               const SDL_FRect *hitbox,
+                               VecTileGridEntry *collisions);
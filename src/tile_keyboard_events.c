@@ -1,12 +1,18 @@
+#define ALLOC_TAG ALLOC_TAG_KEYMAP
+
+#include "arena.h"
 #include "csv.h"
 #include "hashmap.h"
 #include "tile_keyboard_events.h"
 #include "utils.h"
 #include "vec.h"
 
+// Most keys have only a few subscribers, room for this many is made up front.
+#define TILE_KEYBOARD_EVENTS_SUBSCRIBERS_CAPACITY 4
+
 static size_t tile_keyboard_hash_SDL_Keycode(const SDL_Keycode *key)
 {
-    return hashmap_hash_default(key, sizeof(*key));
+    return hashmap_hash_fast(key, sizeof(*key));
 }
 
 static int tile_keyboard_compare_SDL_Keycode(const SDL_Keycode *a,
@@ -30,11 +36,16 @@ static void tile_keyboard_free_SDL_Keycode(SDL_Keycode *key)
 KeyEventSubscribers *tile_keyboard_events_create()
 {
     KeyEventSubscribers *subscribers = xmalloc(sizeof(*subscribers));
-    hashmap_init(subscribers, tile_keyboard_hash_SDL_Keycode,
+    hashmap_init(&subscribers->by_key, tile_keyboard_hash_SDL_Keycode,
                  tile_keyboard_compare_SDL_Keycode);
-    hashmap_set_key_alloc_funcs(subscribers, tile_keyboard_copy_SDL_Keycode,
+    hashmap_set_key_alloc_funcs(&subscribers->by_key,
+                                tile_keyboard_copy_SDL_Keycode,
                                 tile_keyboard_free_SDL_Keycode);
 
+    memset(subscribers->table.offsets, 0, sizeof(subscribers->table.offsets));
+    subscribers->table.callbacks = vector_create();
+    subscribers->table_dirty = true;
+
     return subscribers;
 }
 
@@ -42,7 +53,7 @@ void tile_keyboard_events_destroy(KeyEventSubscribers *subscribers)
 {
     vec_TileCallback subscribed_callbacks;
 
-    hashmap_foreach_data(subscribed_callbacks, subscribers)
+    hashmap_foreach_data(subscribed_callbacks, &subscribers->by_key)
     {
         TileCallback *callback;
         vector_foreach(callback, subscribed_callbacks)
@@ -53,7 +64,8 @@ void tile_keyboard_events_destroy(KeyEventSubscribers *subscribers)
         vector_free(subscribed_callbacks);
     }
 
-    hashmap_cleanup(subscribers);
+    hashmap_cleanup(&subscribers->by_key);
+    vector_free(subscribers->table.callbacks);
     free(subscribers);
 }
 
@@ -61,50 +73,133 @@ void tile_keyboard_events_subscribe_dynamic(KeyEventSubscribers *subscribers,
                                             SDL_Keycode key,
                                             TileCallback *callback)
 {
-    vec_TileCallback subscribed_callbacks = hashmap_remove(subscribers, &key);
+    vec_TileCallback subscribed_callbacks =
+        hashmap_get(&subscribers->by_key, &key);
+    vec_TileCallback old_subscribed_callbacks = subscribed_callbacks;
     if (!subscribed_callbacks)
     {
-        subscribed_callbacks = vector_create();
+        subscribed_callbacks = vector_create_with_capacity(
+            TileCallback *, TILE_KEYBOARD_EVENTS_SUBSCRIBERS_CAPACITY);
     }
 
     // NOLINTNEXTLINE(bugprone-sizeof-expression)
     vector_add(&subscribed_callbacks, callback);
 
-    hashmap_put(subscribers, &key, subscribed_callbacks);
+    // The map only needs updating if the vector was created or moved.
+    if (subscribed_callbacks != old_subscribed_callbacks)
+    {
+        if (old_subscribed_callbacks)
+            hashmap_remove(&subscribers->by_key, &key);
+
+        hashmap_put(&subscribers->by_key, &key, subscribed_callbacks);
+    }
+
+    subscribers->table_dirty = true;
 }
 
 void tile_keyboard_events_unsubscribe(KeyEventSubscribers *subscribers,
                                       SDL_Keycode key, TileCallback *callback)
 {
-    vec_TileCallback subscribed_callbacks = hashmap_remove(subscribers, &key);
+    vec_TileCallback subscribed_callbacks =
+        hashmap_get(&subscribers->by_key, &key);
 
     if (!subscribed_callbacks)
         return;
 
+    // Removing never moves the vector, so the map stays as is.
     for (size_t i = 0; i < vector_size(subscribed_callbacks); i++)
     {
         if (subscribed_callbacks[i] == callback)
         {
             vector_remove(&subscribed_callbacks, i);
+            subscribers->table_dirty = true;
             break;
         }
     }
+}
 
-    hashmap_put(subscribers, &key, subscribed_callbacks);
+void tile_keyboard_events_invalidate(KeyEventSubscribers *subscribers)
+{
+    subscribers->table_dirty = true;
+}
+
+/**
+ * @brief Compiles the subscribers by keycode into the dispatch table by
+ *          scancode: counts the callbacks of each scancode, turns the counts
+ *          into offsets, and then places the callbacks.
+ */
+static void tile_keyboard_events_compile(KeyEventSubscribers *subscribers)
+{
+    KeyDispatchTable *table = &subscribers->table;
+    memset(table->offsets, 0, sizeof(table->offsets));
+
+    const SDL_Keycode *key;
+    vec_TileCallback subscribed_callbacks;
+    hashmap_foreach(key, subscribed_callbacks, &subscribers->by_key)
+    {
+        // Keys with no scancode go with SDL_SCANCODE_UNKNOWN.
+        SDL_Scancode scancode = SDL_GetScancodeFromKey(*key);
+        if (scancode == SDL_SCANCODE_UNKNOWN && *key != SDLK_UNKNOWN)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
+                        "Key %d has no scancode in the current keyboard "
+                        "layout, its subscribers will get unknown keys",
+                        *key);
+        }
+
+        // Counted one slot ahead, so the prefix sum gives the start offsets.
+        table->offsets[scancode + 1] += vector_size(subscribed_callbacks);
+    }
+
+    for (size_t i = 1; i <= SDL_NUM_SCANCODES; i++)
+    {
+        table->offsets[i] += table->offsets[i - 1];
+    }
+
+    // NOLINTNEXTLINE(bugprone-sizeof-expression)
+    vector_resize(&table->callbacks, table->offsets[SDL_NUM_SCANCODES]);
+
+    // Each scancode's offset is used as its cursor, and ends up at the start
+    // of the next scancode, so the offsets are shifted back after placing.
+    hashmap_foreach(key, subscribed_callbacks, &subscribers->by_key)
+    {
+        SDL_Scancode scancode = SDL_GetScancodeFromKey(*key);
+        TileCallback *callback;
+        vector_foreach(callback, subscribed_callbacks)
+        {
+            table->callbacks[table->offsets[scancode]++] = callback;
+        }
+    }
+
+    for (size_t i = SDL_NUM_SCANCODES; i > 0; i--)
+    {
+        table->offsets[i] = table->offsets[i - 1];
+    }
+    table->offsets[0] = 0;
+
+    subscribers->table_dirty = false;
 }
 
 void tile_keyboard_events_notify(KeyEventSubscribers *subscribers,
-                                 SDL_Keycode key, CallbackGameState *game_info)
+                                 const SDL_Keysym *keysym,
+                                 CallbackGameState *game_info)
 {
-    game_info->key = key;
-    TileCallback **subscribed_callbacks = hashmap_get(subscribers, &key);
+    if (subscribers->table_dirty)
+        tile_keyboard_events_compile(subscribers);
 
-    if (!subscribed_callbacks)
+    game_info->event = TILE_EVENT_KEY;
+    game_info->key = keysym->sym;
+
+    const KeyDispatchTable *table = &subscribers->table;
+    if ((size_t)keysym->scancode >= SDL_NUM_SCANCODES)
         return;
 
-    TileCallback *callback;
-    vector_foreach(callback, subscribed_callbacks)
+    /* Callbacks which (un)subscribe only mark the table as dirty, so it
+     * doesn't change while its callbacks are walked. */
+    Uint32 end = table->offsets[keysym->scancode + 1];
+    for (Uint32 i = table->offsets[keysym->scancode]; i < end; i++)
     {
+        TileCallback *callback = table->callbacks[i];
         game_info->tile_texture_id = callback->id;
 
         callback->func(callback->args, game_info);
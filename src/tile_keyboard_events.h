@@ -30,7 +30,28 @@
 
 typedef TileCallback **vec_TileCallback;
 
-typedef HASHMAP(SDL_Keycode, TileCallback *) KeyEventSubscribers;
+typedef HASHMAP(SDL_Keycode, TileCallback *) KeyEventSubscribersHashmap;
+
+/*
+ * The subscribers compiled into a flat table indexed by scancode. The
+ * callbacks of each scancode are contiguous in a single array, so
+ * dispatching a key is an index and a walk over its callbacks.
+ */
+typedef struct KeyDispatchTable
+{
+    // The callbacks of scancode i are callbacks[offsets[i]..offsets[i + 1]).
+    Uint32 offsets[SDL_NUM_SCANCODES + 1];
+    vec_TileCallback callbacks;
+} KeyDispatchTable;
+
+typedef struct KeyEventSubscribers
+{
+    // Subscribers by keycode, changed by (un)subscribing.
+    KeyEventSubscribersHashmap by_key;
+    // Compiled from by_key, used for dispatching.
+    KeyDispatchTable table;
+    bool table_dirty; // Set when by_key changes, or when the keymap does.
+} KeyEventSubscribers;
 
 /**
  * @brief Creates a new map for keyboard events subscribers.
@@ -77,16 +98,27 @@ void tile_keyboard_events_subscribe_dynamic(KeyEventSubscribers *subscribers,
 void tile_keyboard_events_unsubscribe(KeyEventSubscribers *subscribers,
                                       SDL_Keycode key, TileCallback *callback);
 
+/**
+ * @brief Marks the dispatch table as out of date, e.g. when the keyboard
+ *          layout changes. It's recompiled on the next notify.
+ */
+void tile_keyboard_events_invalidate(KeyEventSubscribers *subscribers);
+
 /**
  * @brief Notifies (calls) all the subscribers for a given key with their args.
+ *          Recompiles the dispatch table first if the subscribers changed.
+ *
+ * Callbacks may (un)subscribe, which takes effect from the next notify.
  *
- * @param key The event keycode subscribers of which to notify.
+ * @param keysym The event key subscribers of which to notify. The
+ *                  subscribers are looked up by its scancode.
  * @param game_state The current state of the game to be used by the callback.
- *                      The key will be auto set by the key parameter.
+ *                      The event will be auto set to TILE_EVENT_KEY and
+ *                      the key to the keysym's keycode.
  *                      The id will be also auto set.
  */
 void tile_keyboard_events_notify(KeyEventSubscribers *subscribers,
-                                 SDL_Keycode key,
+                                 const SDL_Keysym *keysym,
                                  CallbackGameState *game_state);
 
 /**
@@ -0,0 +1,127 @@
+#include "SDL.h"
+#include "level.h"
+#include "tile_callback.h"
+#include "tile_grid.h"
+#include "tile_overlaps.h"
+#include "utils.h"
+#include "vec.h"
+
+TileOverlapTracker *tile_overlaps_create()
+{
+    TileOverlapTracker *tracker = xmalloc(sizeof(*tracker));
+    tracker->level = NULL;
+    tracker->overlaps =
+        vector_create_with_capacity(TileOverlap, TILE_OVERLAPS_CAPACITY);
+    tracker->previous_overlaps =
+        vector_create_with_capacity(TileOverlap, TILE_OVERLAPS_CAPACITY);
+    tracker->collisions =
+        vector_create_with_capacity(TileGridEntry, TILE_OVERLAPS_CAPACITY);
+    tracker->events =
+        vector_create_with_capacity(TileEvent, TILE_OVERLAPS_CAPACITY);
+
+    return tracker;
+}
+
+void tile_overlaps_destroy(TileOverlapTracker *tracker)
+{
+    vector_free(tracker->overlaps);
+    vector_free(tracker->previous_overlaps);
+    vector_free(tracker->collisions);
+    vector_free(tracker->events);
+    free(tracker);
+}
+
+void tile_overlaps_reset(TileOverlapTracker *tracker)
+{
+    tracker->level = NULL;
+    vector_resize(&tracker->overlaps, 0);
+    vector_resize(&tracker->previous_overlaps, 0);
+    vector_resize(&tracker->events, 0);
+}
+
+/**
+ * @brief Queues an event if the tile's callback is triggered by it.
+ */
+static void tile_overlaps_queue(TileOverlapTracker *tracker,
+                                TileEventType type,
+                                const TileCallback *callback)
+{
+    if (!(callback->triggers & TILE_CALLBACK_TRIGGER(type)))
+        return;
+
+    vector_add(&tracker->events, ((TileEvent){type, *callback}));
+}
+
+static bool tile_overlaps_contain(VecTileOverlap overlaps, Uint64 key)
+{
+    for (size_t i = 0; i < vector_size(overlaps); i++)
+    {
+        if (overlaps[i].key == key)
+            return true;
+    }
+
+    return false;
+}
+
+void tile_overlaps_update(TileOverlapTracker *tracker, const Level *level,
+                          const SDL_FRect *hitbox)
+{
+    if (level != tracker->level)
+    {
+        tile_overlaps_reset(tracker);
+        tracker->level = level;
+    }
+
+    // The overlaps of the last update become the previous ones.
+    VecTileOverlap previous_overlaps = tracker->overlaps;
+    tracker->overlaps = tracker->previous_overlaps;
+    tracker->previous_overlaps = previous_overlaps;
+    vector_resize(&tracker->overlaps, 0);
+
+    vector_resize(&tracker->collisions, 0);
+    tile_grid_find_collisions(level->trigger_grid, level->layers, hitbox,
+                              &tracker->collisions);
+
+    // There are only a few overlaps, so the sets are compared linearly.
+    vector_iter(entry, tracker->collisions)
+    {
+        const Tile *tile = &level->layers[entry->layer]->tiles[entry->tile];
+        TileOverlap overlap = {
+            .key = (Uint64)entry->layer << 32 | entry->tile,
+            .callback = tile->callback,
+        };
+        vector_add(&tracker->overlaps, overlap);
+
+        TileEventType type =
+            tile_overlaps_contain(previous_overlaps, overlap.key)
+                ? TILE_EVENT_STAY
+                : TILE_EVENT_ENTER;
+        tile_overlaps_queue(tracker, type, &overlap.callback);
+    }
+
+    vector_iter(previous_overlap, previous_overlaps)
+    {
+        if (!tile_overlaps_contain(tracker->overlaps, previous_overlap->key))
+        {
+            tile_overlaps_queue(tracker, TILE_EVENT_EXIT,
+                                &previous_overlap->callback);
+        }
+    }
+}
+
+void tile_overlaps_dispatch(TileOverlapTracker *tracker,
+                            CallbackGameState *game_state)
+{
+    vector_iter(event, tracker->events)
+    {
+        if (*game_state->level_ptr != tracker->level)
+            break;
+
+        game_state->event = event->type;
+        game_state->tile_texture_id = event->callback.id;
+
+        event->callback.func(event->callback.args, game_state);
+    }
+
+    vector_resize(&tracker->events, 0);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "SDL.h"
+#include "level.h"
+#include "tile.h"
+#include "tile_callback.h"
+#include "tile_grid.h"
+
+// The amount of overlaps and events tracked without growing. The character
+// overlaps only a few tiles at once.
+#define TILE_OVERLAPS_CAPACITY 32
+
+// A trigger tile the character overlaps.
+typedef struct TileOverlap
+{
+    Uint64 key; // The layer and the index of the tile.
+    TileCallback callback;
+} TileOverlap;
+
+typedef TileOverlap *VecTileOverlap;
+
+typedef struct TileEvent
+{
+    TileEventType type;
+    TileCallback callback;
+} TileEvent;
+
+typedef TileEvent *VecTileEvent;
+
+/*
+ * Tracks the trigger tiles the character overlaps from frame to frame, and
+ * queues enter, stay and exit events for the tiles with callbacks triggered
+ * by them. The events are dispatched all at once, after physics.
+ */
+typedef struct TileOverlapTracker
+{
+    const Level *level; // The level of the tracked overlaps.
+    VecTileOverlap overlaps;
+    VecTileOverlap previous_overlaps;
+    VecTileGridEntry collisions; // Reused by every update.
+    VecTileEvent events;
+} TileOverlapTracker;
+
+/**
+ * @brief Creates an overlap tracker, with room for TILE_OVERLAPS_CAPACITY
+ *          overlaps and events.
+ *
+ * @see tile_overlaps_destroy
+ */
+TileOverlapTracker *tile_overlaps_create();
+
+/**
+ * @brief Destroys the overlap tracker.
+ */
+void tile_overlaps_destroy(TileOverlapTracker *tracker);
+
+/**
+ * @brief Forgets the tracked overlaps and the queued events, without any exit
+ *          events. Done automatically when the level changes.
+ */
+void tile_overlaps_reset(TileOverlapTracker *tracker);
+
+/**
+ * @brief Finds the trigger tiles the hitbox overlaps, and queues the events
+ *          for the changes since the last update.
+ *
+ * @param level The current level. If it's not the level of the last update,
+ *                  the tracker is reset first.
+ * @param hitbox The character's hitbox, after it has moved.
+ *
+ * @see tile_overlaps_dispatch
+ */
+void tile_overlaps_update(TileOverlapTracker *tracker, const Level *level,
+                          const SDL_FRect *hitbox);
+
+/**
+ * @brief Calls the callbacks of the queued events, and clears the queue.
+ *          Stops if a callback changes the level, as the rest of the events
+ *          are of the previous level.
+ *
+ * @param game_state The current state of the game to be used by the callback.
+ *                      The event and the id will be auto set.
+ */
+void tile_overlaps_dispatch(TileOverlapTracker *tracker,
+                            CallbackGameState *game_state);
@@ -1,12 +1,16 @@
-#include "SDL_image.h"
+#define ALLOC_TAG ALLOC_TAG_TILESET
+
 #include "csv.h"
 #include "tile.h"
 #include "tile_callback.h"
 #include "tileset.h"
 #include "utils.h"
 #include "vec.h"
+#include "vfs.h"
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 void tileset_entry_init(TilesetEntry *entry, int id, SDL_Texture *texture)
 {
@@ -43,27 +47,26 @@ void tileset_destroy(Tileset *tileset)
 }
 
 /**
- * @brief Concatenates two paths.
+ * @brief Concatenates two paths into a buffer.
  *
+ * @param[out] path The buffer to write the concatenated path into.
+ * @param path_size The size of the buffer.
  * @param path1 The first path.
  * @param path2 The second path.
  * @param dir_separator The char used to separate the paths.
- * @return The concatenated path (dynamically allocated).
+ * @return True if the path fit into the buffer, false otherwise.
  */
-char *concat_path(const char *path1, const char *path2,
-                  const char path_separator)
+bool concat_path(char *path, size_t path_size, const char *path1,
+                 const char *path2, const char path_separator)
 {
-    bool dir_sep_needed = path1[strlen(path1) - 1] != path_separator;
-
-    char *path =
-        xmalloc(strlen(path1) + (int)dir_sep_needed + strlen(path2) + 1);
+    size_t path1_len = strlen(path1);
+    bool dir_sep_needed = path1_len && path1[path1_len - 1] != path_separator;
 
-    strcpy(path, path1);
-    if (dir_sep_needed)
-        strcat(path, (char[]){path_separator, '\0'});
-    strcat(path, path2);
+    int written = snprintf(path, path_size, "%s%s%s", path1,
+                           dir_sep_needed ? (char[]){path_separator, '\0'} : "",
+                           path2);
 
-    return path;
+    return written >= 0 && (size_t)written < path_size;
 }
 
 // NOTE: if you prepend a type to the enum,
@@ -82,46 +85,11 @@ enum FieldType
 struct TilesetLoadingData
 {
     enum FieldType type;
+    const Vfs *vfs;
     SDL_Renderer *renderer;
     Tileset *tileset;
 };
 
-typedef vec_char *vec_str;
-
-/**
- * @brief Splits the given string on the given chars and returns
- *          a vector of tokens after split.
- *        The out vector is managed by the caller, both the vec and the
- *          vector and then strings (char vectors) inside.
- *
- * @param str The string to split.
- * @param ch The chars to split at.
- * @return Vector of strings (char vectors).
- *      All managed by the caller.
- */
-vec_str str_split(const char *str, char ch)
-{
-    vec_str tokens = vector_create();
-
-    vec_char curr_string = vector_create();
-
-    do
-    {
-        if (*str == ch || *str == '\0')
-        {
-            vector_add(&curr_string, '\0');
-            vector_add(&tokens, curr_string);
-            curr_string = vector_create();
-            continue;
-        }
-
-        vector_add(&curr_string, *str);
-    } while (*str++);
-
-    vector_free(curr_string);
-    return tokens;
-}
-
 void tileset_field_parser_callback(void *field_bytes, size_t, void *data)
 {
     struct TilesetLoadingData *tileset_loading_data = data;
@@ -142,13 +110,18 @@ void tileset_field_parser_callback(void *field_bytes, size_t, void *data)
             break;
         case FIELD_PATH:
         {
-            char *texture_path = concat_path(tileset->texture_dir_path,
-                                             field_str, DIR_SEPARATOR);
+            char texture_path[PACK_PATH_MAX];
+            if (!concat_path(texture_path, sizeof(texture_path),
+                             tileset->texture_dir_path, field_str,
+                             DIR_SEPARATOR))
+            {
+                die("Texture path %s%c%s is too long",
+                    tileset->texture_dir_path, DIR_SEPARATOR, field_str);
+            }
 
             last_entry->texture =
-                IMG_LoadTexture(tileset_loading_data->renderer, texture_path);
-
-            free(texture_path);
+                vfs_load_texture(tileset_loading_data->vfs,
+                                 tileset_loading_data->renderer, texture_path);
             break;
         }
         case FIELD_SOLID:
@@ -156,11 +129,13 @@ void tileset_field_parser_callback(void *field_bytes, size_t, void *data)
             break;
         case FIELD_CALLBACK:
         {
-            vec_str callback_tokens = str_split(field_str, ' ');
+            // The command name is the first word, and its args follow it.
+            int command_name_len = strcspn(field_str, " ");
+            const char *command_args = field_str + command_name_len;
+            command_args += strspn(command_args, " ");
 
-            vec_char command_name = callback_tokens[0];
             const TileCallbackInfo *callback_info =
-                tile_callback_get(command_name);
+                tile_callback_get(field_str, command_name_len);
 
             SDL_assert(callback_info != NULL &&
                        "Tileset callback command not found");
@@ -168,46 +143,34 @@ void tileset_field_parser_callback(void *field_bytes, size_t, void *data)
             if (callback_info == NULL) // In case asserts are off.
             {
                 SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
-                            "Command '%s' in callback '%s' was not found. "
+                            "Command '%.*s' in callback '%s' was not found. "
                             "Interpreting as command of type none.",
-                            command_name, field_str);
+                            command_name_len, field_str, field_str);
 
-                callback_info = tile_callback_get("");
+                callback_info = tile_callback_get("", 0);
             }
 
             TileCallbackFunction callback = callback_info->callback;
             SDL_assert(callback != NULL);
 
             TileArguments callback_args;
-            if (vector_size(callback_tokens) > 1)
+            if (*command_args != '\0')
             {
-                /* It's not a vec_str anymore, but a (vec_char *).
-                 * Because we added +1, all the `vector_` functions will produce
-                 * undefined behavior. */
-                vec_char *command_args_tokens = callback_tokens + 1;
-                size_t command_args_tokens_size =
-                    vector_size(callback_tokens) - 1;
-
                 switch (callback_info->type)
                 {
                     case TILE_CALLBACK_NONE:
                     case TILE_CALLBACK_LADDER:
                         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION,
-                                    "The command '%s' has no arguments, but "
+                                    "The command '%.*s' has no arguments, but "
                                     "they were given in callback '%s'.",
-                                    command_name, field_str);
+                                    command_name_len, field_str, field_str);
                         break;
                 }
             }
             callback_args.type = callback_info->type;
 
-            for (size_t i = 0; i < vector_size(callback_tokens); i++)
-            {
-                vector_free(callback_tokens[i]);
-            }
-            vector_free(callback_tokens);
-
             last_entry->callback = callback;
+            last_entry->triggers = callback_info->triggers;
             last_entry->args = callback_args;
             break;
         }
@@ -231,7 +194,7 @@ void tileset_row_parser_callback(int, void *data)
     tileset_loading_data->type = FIELD_ID; // Reset the type to the first one
 }
 
-Tileset *tileset_load(FILE *stream, char *texture_dir_path,
+Tileset *tileset_load(const Vfs *vfs, FILE *stream, char *texture_dir_path,
                       SDL_Renderer *renderer)
 {
     struct csv_parser parser;
@@ -249,9 +212,16 @@ Tileset *tileset_load(FILE *stream, char *texture_dir_path,
      * For each field, we check what type of field it is, and write it.
      */
     struct TilesetLoadingData tileset_loading_data = {
+        .vfs = vfs,
         .renderer = renderer,
         .tileset = tileset_create(texture_dir_path),
         .type = FIELD_ID};
+
+    // Reserve for the estimated amount of rows (and the extra empty entry),
+    // the unused capacity is released after loading.
+    vector_reserve(&tileset_loading_data.tileset->entries,
+                   stream_remaining_size(stream) / TILESET_ESTIMATED_ROW_SIZE +
+                       2);
     vector_add(&tileset_loading_data.tileset->entries, (TilesetEntry){0});
 
     char buf[1024] = {0};
@@ -280,6 +250,7 @@ Tileset *tileset_load(FILE *stream, char *texture_dir_path,
     // NOLINTNEXTLINE(bugprone-sizeof-expression)
     vector_remove(&tileset_loading_data.tileset->entries,
                   vector_size(tileset_loading_data.tileset->entries) - 1);
+    vector_shrink_to_fit(&tileset_loading_data.tileset->entries);
 
     return tileset_loading_data.tileset;
 }
@@ -301,7 +272,8 @@ int tileset_query_texture_by_id(const Tileset *tileset, int id,
             if (solid)
                 *solid = entry->solid;
             if (callback)
-                *callback = (TileCallback){entry->callback, &entry->args, id};
+                *callback = (TileCallback){entry->callback, &entry->args,
+                                           entry->triggers, id};
             if (class_id)
                 *class_id = entry->class_id;
             if (hitbox_offset)
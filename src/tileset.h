@@ -3,9 +3,13 @@
 #include "SDL.h"
 #include "tile.h"
 #include "tile_callback.h"
+#include "vfs.h"
 
 #define DIR_SEPARATOR '/'
 
+// Used to estimate the amount of entries from the size of a tileset file.
+#define TILESET_ESTIMATED_ROW_SIZE 32
+
 typedef struct TilesetEntry
 {
     bool solid;
@@ -14,6 +18,7 @@ typedef struct TilesetEntry
     SDL_FPoint hitbox_offset;
     SDL_Texture *texture;
     TileCallbackFunction callback;
+    TileCallbackTriggers triggers;
     TileArguments args;
 } TilesetEntry;
 
@@ -46,6 +51,7 @@ void tileset_entry_cleanup(TilesetEntry *entry);
 /**
  * @brief Creates a tileset from a csv stream.
  *
+ * @param vfs The file system to load the textures from.
  * @param stream The csv stream where each row is `id,texture_path`.
  * @param texture_dir_path The path to the texture directory. (Managed by the tileset)
  * @see Tileset
@@ -54,7 +60,7 @@ void tileset_entry_cleanup(TilesetEntry *entry);
  *
  * @see tileset_destroy
  */
-Tileset *tileset_load(FILE *stream, char *texture_dir_path,
+Tileset *tileset_load(const Vfs *vfs, FILE *stream, char *texture_dir_path,
                       SDL_Renderer *renderer);
 
 /**
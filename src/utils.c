@@ -17,7 +17,8 @@ void die(const char *fmt, ...)
     exit(EXIT_FAILURE);
 }
 
-void *xmalloc(size_t size)
+// The parentheses keep the names from expanding to the ALLOC_STATS macros.
+void *(xmalloc)(size_t size)
 {
     void *p = malloc(size);
     if (!p)
@@ -25,7 +26,7 @@ void *xmalloc(size_t size)
     return p;
 }
 
-void *xrealloc(void *ptr, size_t size)
+void *(xrealloc)(void *ptr, size_t size)
 {
     void *p = realloc(ptr, size);
     if (!p)
@@ -61,3 +62,47 @@ char *readline(FILE *stream, const char eol_char, size_t starting_size,
 
     return (char *)realloc(str, sizeof(char) * (len + 1));
 }
+
+size_t stream_remaining_size(FILE *stream)
+{
+    long position = ftell(stream);
+    if (position < 0 || fseek(stream, 0, SEEK_END) != 0)
+        return 0;
+
+    long end = ftell(stream);
+    fseek(stream, position, SEEK_SET);
+
+    return end > position ? end - position : 0;
+}
+
+char *read_stream_tagged(AllocTag tag, FILE *stream, size_t *size)
+{
+    size_t len = 0;
+    // Room for the whole stream and the terminator, so a seekable stream is
+    // read without growing the buffer.
+    size_t alloc = stream_remaining_size(stream) + 1;
+    if (alloc < UTILS_READ_STREAM_CHUNK_SIZE)
+        alloc = UTILS_READ_STREAM_CHUNK_SIZE;
+    char *buf = xmalloc_tagged(tag, alloc);
+
+    size_t bytes_read = 0;
+    do
+    {
+        // Grow only once the buffer is full and there could be more to read.
+        if (alloc - len == 1)
+            buf = xrealloc_tagged(tag, buf, alloc *= 2);
+
+        bytes_read = fread(buf + len, 1, alloc - len - 1, stream);
+        len += bytes_read;
+    } while (bytes_read > 0);
+
+    buf[len] = '\0';
+    *size = len;
+
+    return buf;
+}
+
+char *(read_stream)(FILE *stream, size_t *size)
+{
+    return read_stream_tagged(ALLOC_TAG_OTHER, stream, size);
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include "alloc_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 
 #define UTILS_READLINE_DEFAULT_STARTING_SIZE 16
 #define UTILS_READLINE_DEFAULT_SCALING_FACTOR 2
+#define UTILS_READ_STREAM_CHUNK_SIZE 4096
 
 /**
  * @brief Logs the given message using SDL and exits with EXIT_FAILURE
@@ -28,6 +30,36 @@ void *xmalloc(size_t size);
  */
 void *xrealloc(void *ptr, size_t size);
 
+/**
+ * @brief Counts the allocation under the given tag, then calls `xmalloc`.
+ */
+static inline void *xmalloc_tagged(AllocTag tag, size_t size)
+{
+    alloc_stats_record(tag, size);
+    return xmalloc(size);
+}
+
+/**
+ * @brief Counts the allocation under the given tag, then calls `xrealloc`.
+ */
+static inline void *xrealloc_tagged(AllocTag tag, void *ptr, size_t size)
+{
+    alloc_stats_record(tag, size);
+    return xrealloc(ptr, size);
+}
+
+#ifdef ALLOC_STATS
+#ifndef ALLOC_TAG
+#define ALLOC_TAG ALLOC_TAG_OTHER
+#endif
+
+// Count every allocation under the tag of the calling translation unit. The
+// arguments are evaluated once, as callers grow buffers like
+// `xrealloc(buf, size *= 2)`.
+#define xmalloc(size) xmalloc_tagged(ALLOC_TAG, (size))
+#define xrealloc(ptr, size) xrealloc_tagged(ALLOC_TAG, (ptr), (size))
+#endif
+
 /**
  * @brief Reads a line from the given stream up until the given eol character.
  *
@@ -43,3 +75,32 @@ void *xrealloc(void *ptr, size_t size);
  */
 char *readline(FILE *stream, const char eol_char, size_t starting_size,
                size_t scaling_factor);
+
+/**
+ * @brief Gets the amount of bytes left in the given stream, without moving
+ *          it.
+ *
+ * @return The amount of bytes left, or 0 if the stream isn't seekable.
+ */
+size_t stream_remaining_size(FILE *stream);
+
+/**
+ * @brief Reads everything left in the given stream.
+ *
+ * @param stream The stream to read from.
+ * @param[out] size The amount of bytes read.
+ * @return Dynamically allocated buffer with the read data, null terminated
+ *          (the terminator is not counted in size).
+ */
+char *read_stream(FILE *stream, size_t *size);
+
+/**
+ * @brief `read_stream`, with the buffer counted under the given tag.
+ */
+char *read_stream_tagged(AllocTag tag, FILE *stream, size_t *size);
+
+#ifdef ALLOC_STATS
+// The buffer is counted under the tag of the caller, like xmalloc.
+#define read_stream(stream, size)                                              \
+    read_stream_tagged(ALLOC_TAG, (stream), (size))
+#endif
@@ -4,25 +4,16 @@
 //  Created by Mashpoe on 2/26/19.
 //
 
+#define ALLOC_TAG ALLOC_TAG_VEC
+
 #include "vec.h"
+#include "arena.h"
 #include "utils.h"
 #include <string.h>
 
-typedef struct vector_data vector_data;
-
-struct vector_data
+vec_size_t vector_alloc_size(vec_size_t capacity, vec_type_t type_size)
 {
-	vec_size_t alloc; // stores the number of bytes allocated
-	vec_size_t length;
-	char buff[]; // use char to store bytes of an unknown type
-};
-
-vector_data* vector_alloc(vec_size_t alloc, vec_size_t size)
-{
-	vector_data* v_data = (vector_data*)
-		xmalloc(sizeof(vector_data) + alloc * size);
-	v_data->alloc = alloc;
-	return v_data;
+	return sizeof(vector_data) + capacity * type_size;
 }
 
 vector_data* vector_get_data(vector vec) { return &((vector_data*)vec)[-1]; }
@@ -32,25 +23,105 @@ vector vector_create(void)
 	vector_data* v = (vector_data*)xmalloc(sizeof(vector_data));
 	v->alloc = 0;
 	v->length = 0;
+	v->arena = NULL;
+	v->is_inline = false;
+
+	return &v->buff;
+}
+
+vector _vector_create_with_capacity(vec_type_t type_size, vec_size_t capacity)
+{
+	vector_data* v =
+	    (vector_data*)xmalloc(vector_alloc_size(capacity, type_size));
+	v->alloc = capacity;
+	v->length = 0;
+	v->arena = NULL;
+	v->is_inline = false;
+
+	return &v->buff;
+}
+
+vector _vector_init_small(vector_data* header, Arena* arena,
+			  vec_size_t capacity)
+{
+	header->alloc = capacity;
+	header->length = 0;
+	header->arena = arena;
+	header->is_inline = true;
+
+	return &header->buff;
+}
+
+vector vector_create_in(Arena* arena)
+{
+	vector_data* v = (vector_data*)arena_alloc(arena, sizeof(vector_data));
+	v->alloc = 0;
+	v->length = 0;
+	v->arena = arena;
+	v->is_inline = false;
 
 	return &v->buff;
 }
 
-void vector_free(vector vec) { free(vector_get_data(vec)); }
+void vector_free(vector vec)
+{
+	vector_data* v_data = vector_get_data(vec);
+
+	if (!v_data->arena && !v_data->is_inline)
+		free(v_data);
+}
 
 vec_size_t vector_size(vector vec) { return vector_get_data(vec)->length; }
 
 vec_size_t vector_get_alloc(vector vec) { return vector_get_data(vec)->alloc; }
 
-vector_data* vector_realloc(vector_data* v_data, vec_type_t type_size)
+vector_data* vector_realloc_to(vector_data* v_data, vec_type_t type_size,
+			       vec_size_t new_alloc)
 {
-	vec_size_t new_alloc = (v_data->alloc == 0) ? 1 : v_data->alloc * 2;
-	vector_data* new_v_data = (vector_data*)
-	    xrealloc(v_data, sizeof(vector_data) + new_alloc * type_size);
+	vector_data* new_v_data;
+
+	if (v_data->arena || v_data->is_inline)
+	{
+		// Neither arena memory nor inline storage can be resized, the
+		// old buffer is left where it is.
+		size_t alloc_size = vector_alloc_size(new_alloc, type_size);
+		new_v_data = v_data->arena ? (vector_data*)arena_alloc(
+						 v_data->arena, alloc_size)
+					   : (vector_data*)xmalloc(alloc_size);
+		memcpy(new_v_data, v_data,
+		       vector_alloc_size(v_data->length, type_size));
+		new_v_data->is_inline = false;
+	}
+	else
+	{
+		new_v_data = (vector_data*)xrealloc(
+		    v_data, vector_alloc_size(new_alloc, type_size));
+	}
+
 	new_v_data->alloc = new_alloc;
 	return new_v_data;
 }
 
+vector_data* vector_realloc(vector_data* v_data, vec_type_t type_size)
+{
+	vec_size_t new_alloc = (v_data->alloc < VECTOR_MIN_CAPACITY)
+				   ? VECTOR_MIN_CAPACITY
+				   : v_data->alloc * 2;
+	return vector_realloc_to(v_data, type_size, new_alloc);
+}
+
+void _vector_reserve(vector* vec_addr, vec_type_t type_size,
+		     vec_size_t capacity)
+{
+	vector_data* v_data = vector_get_data(*vec_addr);
+
+	if (v_data->alloc >= capacity)
+		return;
+
+	v_data = vector_realloc_to(v_data, type_size, capacity);
+	*vec_addr = v_data->buff;
+}
+
 bool vector_has_space(vector_data* v_data)
 {
 	return v_data->alloc - v_data->length > 0;
@@ -74,20 +145,60 @@ void* _vector_add(vector* vec_addr, vec_type_t type_size)
 	return (void*)&v_data->buff[type_size * v_data->length++];
 }
 
+// Makes room for amount more elements. Grows to at least twice the capacity,
+// so appending repeatedly stays amortized constant time.
+vector_data* vector_grow_for(vector_data* v_data, vec_type_t type_size,
+			     vec_size_t amount)
+{
+	if (vector_has_space_for(v_data, amount))
+		return v_data;
+
+	vec_size_t new_alloc = v_data->alloc * 2;
+	if (new_alloc < v_data->length + amount)
+		new_alloc = v_data->length + amount;
+
+	return vector_realloc_to(v_data, type_size, new_alloc);
+}
+
+void _vector_append_n(vector* vec_addr, vec_type_t type_size,
+		      const void* items, vec_size_t n)
+{
+	vector_data* v_data = vector_grow_for(vector_get_data(*vec_addr),
+					      type_size, n);
+	*vec_addr = v_data->buff;
+
+	memcpy(&v_data->buff[type_size * v_data->length], items, n * type_size);
+	v_data->length += n;
+}
+
 void _vector_concat(vector *dest_vec_addr, vector source, vec_type_t type_size)
 {
-    vector_data* v_data = vector_get_data(*dest_vec_addr);
-    vector_data* s_data = vector_get_data(source);
+    _vector_append_n(dest_vec_addr, type_size, source, vector_size(source));
+}
 
-    while (!vector_has_space_for(v_data, s_data->length))
-    {
-        v_data = vector_realloc(v_data, type_size);
-        *dest_vec_addr = v_data->buff;
-    }
+void _vector_resize(vector* vec_addr, vec_type_t type_size, vec_size_t length)
+{
+	_vector_reserve(vec_addr, type_size, length);
+	vector_data* v_data = vector_get_data(*vec_addr);
+
+	if (length > v_data->length)
+		memset(&v_data->buff[type_size * v_data->length], 0,
+		       (length - v_data->length) * type_size);
+
+	v_data->length = length;
+}
+
+void _vector_shrink_to_fit(vector* vec_addr, vec_type_t type_size)
+{
+	vector_data* v_data = vector_get_data(*vec_addr);
 
-    memmove(&v_data->buff[type_size * v_data->length], s_data->buff, s_data->length * type_size);
-    v_data->length += s_data->length;
- }
+	if (v_data->arena || v_data->is_inline ||
+	    v_data->alloc == v_data->length)
+		return;
+
+	v_data = vector_realloc_to(v_data, type_size, v_data->length);
+	*vec_addr = v_data->buff;
+}
 
 void* _vector_insert(vector* vec_addr, vec_type_t type_size, vec_size_t pos)
 {
@@ -132,8 +243,23 @@ void vector_pop(vector vec) { --vector_get_data(vec)->length; }
 vector _vector_copy(vector vec, vec_type_t type_size)
 {
 	vector_data* vec_data = vector_get_data(vec);
-	size_t alloc_size = sizeof(vector_data) + vec_data->length * type_size;
+	size_t alloc_size = vector_alloc_size(vec_data->length, type_size);
 	vector_data* v = (vector_data*)xmalloc(alloc_size);
 	memcpy(v, vec_data, alloc_size);
+	v->alloc = v->length; // only the elements were copied
+	v->arena = NULL;      // the copy is always on the heap
+	v->is_inline = false;
+	return (void*)&v->buff;
+}
+
+vector _vector_copy_in(Arena* arena, vector vec, vec_type_t type_size)
+{
+	vector_data* vec_data = vector_get_data(vec);
+	size_t alloc_size = vector_alloc_size(vec_data->length, type_size);
+	vector_data* v = (vector_data*)arena_alloc(arena, alloc_size);
+	memcpy(v, vec_data, alloc_size);
+	v->alloc = v->length;
+	v->arena = arena;
+	v->is_inline = false;
 	return (void*)&v->buff;
 }
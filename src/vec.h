@@ -7,13 +7,36 @@
 #ifndef vec_h
 #define vec_h
 
+#include <assert.h>
+#include <stdalign.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 
+struct Arena;
+
 typedef void* vector; // you can't use this to store vectors, it's just used
 		      // internally as a generic type
 typedef size_t vec_size_t;	  // stores the number of elements
-typedef unsigned char vec_type_t; // stores the number of bytes for a type
+typedef size_t vec_type_t;	  // stores the number of bytes for a type
+
+// Every vector starts with this header, the elements follow it. It's only
+// exposed so small vectors can reserve room for it, use the functions below
+// to access it.
+typedef struct vector_data vector_data;
+
+struct vector_data
+{
+	vec_size_t alloc; // stores the number of bytes allocated
+	vec_size_t length;
+	struct Arena* arena; // NULL when the vector is on the heap
+	bool is_inline;	     // the buffer is the storage of a small vector
+	alignas(max_align_t) char buff[]; // use char to store bytes of an
+					  // unknown type
+};
+
+// The smallest capacity a growing vector is given.
+#define VECTOR_MIN_CAPACITY 4
 
 typedef int* vec_int;
 typedef char* vec_char;
@@ -39,6 +62,11 @@ typedef char* vec_char;
 #define vector_insert(vec_addr, pos, value)                                    \
 	(*vector_insert_asg(vec_addr, pos) = value)
 
+// Like vector_add, but the capacity has to be reserved beforehand.
+#define vector_push_unchecked(vec_addr, value)                                 \
+	(*(typeof(*vec_addr))_vector_add_unchecked(*vec_addr,                 \
+						   sizeof(**vec_addr)) = value)
+
 #define IS_SAME_TYPE(a, b)                                                     \
     _Generic((a), typeof(b): true, default: false)
 
@@ -71,6 +99,9 @@ typedef char* vec_char;
 #define vector_insert(vec_addr, type, pos, value)                              \
 	(*vector_insert_asg(vec_addr, type, pos) = value)
 
+#define vector_push_unchecked(vec_addr, type, value)                           \
+	(*(type*)_vector_add_unchecked(*vec_addr, sizeof(type)) = value)
+
 #endif
 
 // vec is a vector (aka type*)
@@ -80,6 +111,51 @@ typedef char* vec_char;
 	(_vector_remove((vector*)vec, sizeof(*vec), pos))
 
 #define vector_copy(vec) (_vector_copy((vector*)vec, sizeof(*vec)))
+#define vector_copy_in(arena, vec)                                             \
+	(_vector_copy_in(arena, (vector*)vec, sizeof(*vec)))
+
+// vec_addr is a vector* (aka type**)
+#define vector_reserve(vec_addr, capacity)                                     \
+	(_vector_reserve((vector*)vec_addr, sizeof(**vec_addr), capacity))
+
+// items points to n elements
+#define vector_append_n(vec_addr, items, n)                                    \
+	(_vector_append_n((vector*)vec_addr, sizeof(**vec_addr), items, n))
+
+// Elements added by growing the vector are zeroed.
+#define vector_resize(vec_addr, length)                                        \
+	(_vector_resize((vector*)vec_addr, sizeof(**vec_addr), length))
+
+// Only heap vectors are shrunk, arena and small vectors are left as they are.
+#define vector_shrink_to_fit(vec_addr)                                         \
+	(_vector_shrink_to_fit((vector*)vec_addr, sizeof(**vec_addr)))
+
+// type is the type of the elements
+#define vector_create_with_capacity(type, capacity)                            \
+	((type*)_vector_create_with_capacity(sizeof(type), capacity))
+
+#define VECTOR_SMALL_STORAGE(type, capacity)                                   \
+	struct                                                                 \
+	{                                                                      \
+		vector_data header;                                            \
+		type items[capacity];                                          \
+	}
+
+// Declares `name`, a vector of `type` with inline storage for `capacity`
+// elements (on the stack when declared in a function). Only growing past them
+// allocates, from the arena if one is given, otherwise from the heap.
+// vector_free has to be called as with any other vector.
+#define vector_small_in(arena, type, name, capacity)                           \
+	VECTOR_SMALL_STORAGE(type, capacity) VECTOR_CONCAT(name, _storage);    \
+	_Static_assert(offsetof(typeof(VECTOR_CONCAT(name, _storage)), items) \
+			   == sizeof(vector_data),                             \
+		       "the elements of " STRINGIFY(name)                     \
+		       " don't directly follow the header");                   \
+	type* name = _vector_init_small(                                       \
+	    &VECTOR_CONCAT(name, _storage).header, arena, capacity)
+
+#define vector_small(type, name, capacity)                                     \
+	vector_small_in(NULL, type, name, capacity)
 
 #define vector_end(vec) (vec + vector_size(vec))
 
@@ -101,10 +177,40 @@ typedef char* vec_char;
 
 vector vector_create(void);
 
+// The vector's memory comes from the arena. Growing it allocates a new buffer
+// from the arena, and vector_free does nothing (the arena frees it).
+vector vector_create_in(struct Arena* arena);
+
+vector _vector_create_with_capacity(vec_type_t type_size, vec_size_t capacity);
+
+vector _vector_init_small(vector_data* header, struct Arena* arena,
+			  vec_size_t capacity);
+
 void vector_free(vector vec);
 
+// The amount of bytes a vector with the given capacity takes up.
+vec_size_t vector_alloc_size(vec_size_t capacity, vec_type_t type_size);
+
+void _vector_reserve(vector* vec_addr, vec_type_t type_size,
+		     vec_size_t capacity);
+
 vector _vector_add(vector* vec_addr, vec_type_t type_size);
 
+static inline vector _vector_add_unchecked(vector vec, vec_type_t type_size)
+{
+	vector_data* v_data = &((vector_data*)vec)[-1];
+	assert(v_data->length < v_data->alloc);
+
+	return &v_data->buff[type_size * v_data->length++];
+}
+
+void _vector_append_n(vector* vec_addr, vec_type_t type_size,
+		      const void* items, vec_size_t n);
+
+void _vector_resize(vector* vec_addr, vec_type_t type_size, vec_size_t length);
+
+void _vector_shrink_to_fit(vector* vec_addr, vec_type_t type_size);
+
 vector _vector_insert(vector* vec_addr, vec_type_t type_size, vec_size_t pos);
 
 void _vector_concat(vector *dest_vec_addr, vector source, vec_type_t type_size);
@@ -118,6 +224,8 @@ void vector_pop(vector vec);
 
 vector _vector_copy(vector vec, vec_type_t type_size);
 
+vector _vector_copy_in(struct Arena* arena, vector vec, vec_type_t type_size);
+
 vec_size_t vector_size(vector vec);
 
 vec_size_t vector_get_alloc(vector vec);
@@ -0,0 +1,173 @@
+#include "SDL.h"
+#include "SDL_image.h"
+#include "dir.h"
+#include "pack.h"
+#include "utils.h"
+#include "vec.h"
+#include "vfs.h"
+#include <string.h>
+
+Vfs *vfs_create(const char *pack_path)
+{
+    Pack *pack = NULL;
+    if (pack_path)
+    {
+        pack = pack_open(pack_path);
+        if (!pack)
+            return NULL;
+    }
+
+    Vfs *vfs = xmalloc(sizeof(*vfs));
+    vfs->pack = pack;
+
+    return vfs;
+}
+
+void vfs_destroy(Vfs *vfs)
+{
+    if (vfs->pack)
+        pack_close(vfs->pack);
+
+    free(vfs);
+}
+
+FILE *vfs_fopen(const Vfs *vfs, const char *path)
+{
+    if (!vfs->pack)
+        return fopen(path, "rb");
+
+    const PackEntry *entry = pack_find(vfs->pack, path);
+    if (!entry)
+        return NULL;
+
+    // The stream is read only, so the mapped data is never written to.
+    return fmemopen((void *)pack_entry_data(vfs->pack, entry), entry->length,
+                    "rb");
+}
+
+SDL_Texture *vfs_load_texture(const Vfs *vfs, SDL_Renderer *renderer,
+                              const char *path)
+{
+    if (!vfs->pack)
+        return IMG_LoadTexture(renderer, path);
+
+    const PackEntry *entry = pack_find(vfs->pack, path);
+    if (!entry)
+        return NULL;
+
+    SDL_RWops *rw =
+        SDL_RWFromConstMem(pack_entry_data(vfs->pack, entry), entry->length);
+
+    return IMG_LoadTexture_RW(renderer, rw, true);
+}
+
+/**
+ * @brief Lists a directory on the disk.
+ * @see vfs_list_dir
+ */
+static VecPath vfs_list_loose_dir(const char *dir_path)
+{
+    DIR *dir = opendir(dir_path);
+    if (!dir)
+        return NULL;
+
+    VecPath paths = vector_create();
+
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir)))
+    {
+        if (strcmp(dir_entry->d_name, ".") == 0 ||
+            strcmp(dir_entry->d_name, "..") == 0)
+            continue;
+
+        char *path = dir_get_path_to_entry(dir_entry, dir_path);
+
+        // NOLINTNEXTLINE(bugprone-sizeof-expression)
+        vector_add(&paths, path);
+    }
+
+    closedir(dir);
+
+    return paths;
+}
+
+/**
+ * @brief Lists a directory in the pack. Directories are not stored in the
+ *          pack, so they are found from the prefixes of the entry paths.
+ * @see vfs_list_dir
+ */
+static VecPath vfs_list_pack_dir(const Pack *pack, const char *dir_path)
+{
+    char prefix[PACK_PATH_MAX];
+    if (!pack_normalize_path(dir_path, prefix, sizeof(prefix)))
+        return NULL;
+
+    size_t prefix_len = strlen(prefix);
+    bool found = false;
+
+    VecPath paths = vector_create();
+
+    for (uint32_t i = 0; i < pack->header->entry_count; i++)
+    {
+        const char *entry_path = pack_entry_path(pack, &pack->entries[i]);
+
+        if (strncmp(entry_path, prefix, prefix_len) != 0 ||
+            entry_path[prefix_len] != '/')
+            continue;
+
+        found = true;
+
+        const char *name = entry_path + prefix_len + 1;
+        size_t name_len = strcspn(name, "/");
+
+        // The same subdirectory is a prefix of many entries.
+        bool listed = false;
+        char *path;
+        vector_foreach(path, paths)
+        {
+            if (strncmp(path, entry_path, prefix_len + 1 + name_len) == 0 &&
+                path[prefix_len + 1 + name_len] == '\0')
+            {
+                listed = true;
+                break;
+            }
+        }
+
+        if (listed)
+            continue;
+
+        path = xmalloc(prefix_len + 1 + name_len + 1);
+        memcpy(path, entry_path, prefix_len + 1 + name_len);
+        path[prefix_len + 1 + name_len] = '\0';
+
+        // NOLINTNEXTLINE(bugprone-sizeof-expression)
+        vector_add(&paths, path);
+    }
+
+    if (!found)
+    {
+        vector_free(paths);
+        return NULL;
+    }
+
+    return paths;
+}
+
+VecPath vfs_list_dir(const Vfs *vfs, const char *dir_path)
+{
+    if (!vfs->pack)
+        return vfs_list_loose_dir(dir_path);
+
+    return vfs_list_pack_dir(vfs->pack, dir_path);
+}
+
+void vfs_free_paths(VecPath paths)
+{
+    char *path;
+    vector_foreach(path, paths)
+    {
+        free(path);
+    }
+
+    vector_free(paths);
+}
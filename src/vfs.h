@@ -0,0 +1,72 @@
+#pragma once
+
+#include "SDL.h"
+#include "pack.h"
+#include <stdio.h>
+
+typedef char **VecPath;
+
+/*
+ * Virtual file system for the game assets. Reads either from an asset pack or,
+ * when there is no pack, from the loose files on the disk. Paths are the same
+ * in both cases (the pack stores the paths that were given to the packer).
+ */
+typedef struct Vfs
+{
+    Pack *pack; // NULL when reading loose files.
+} Vfs;
+
+/**
+ * @brief Creates a virtual file system.
+ *
+ * @param pack_path The path to the asset pack to read from. When NULL, the
+ *                      loose files are used.
+ * @return The created vfs, or NULL if the pack could not be opened.
+ *
+ * @see vfs_destroy
+ */
+Vfs *vfs_create(const char *pack_path);
+
+/**
+ * @brief Destroys the vfs and closes the pack.
+ *
+ * @warning All the streams and textures loaded from the vfs must not be used
+ *              after this.
+ */
+void vfs_destroy(Vfs *vfs);
+
+/**
+ * @brief Opens a file for binary reading.
+ *
+ * @param path The path to the file.
+ * @return The opened stream (close with fclose), or NULL on failure.
+ */
+FILE *vfs_fopen(const Vfs *vfs, const char *path);
+
+/**
+ * @brief Loads a texture from a file.
+ *
+ * @param renderer The renderer to create the texture with.
+ * @param path The path to the image.
+ * @return The loaded texture, or NULL on failure.
+ */
+SDL_Texture *vfs_load_texture(const Vfs *vfs, SDL_Renderer *renderer,
+                              const char *path);
+
+/**
+ * @brief Lists the entries (both files and directories) directly inside
+ *          a directory.
+ *
+ * @param dir_path The path to the directory.
+ * @return Vector of paths to the entries (parent path included), or NULL if
+ *          the directory does not exist. The vector and the paths are
+ *          managed by the caller.
+ *
+ * @see vfs_free_paths
+ */
+VecPath vfs_list_dir(const Vfs *vfs, const char *dir_path);
+
+/**
+ * @brief Frees a vector of paths returned by vfs_list_dir.
+ */
+void vfs_free_paths(VecPath paths);
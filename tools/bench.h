@@ -0,0 +1,18 @@
+#pragma once
+
+#include "SDL.h"
+
+/*
+ * Helpers shared by the benchmarks in tools/.
+ */
+
+/**
+ * @brief Gets the seconds elapsed since the given performance counter value.
+ *
+ * @param start A value of SDL_GetPerformanceCounter.
+ */
+static inline double bench_seconds_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) /
+           SDL_GetPerformanceFrequency();
+}
@@ -0,0 +1,158 @@
+/*
+ * Compares testing a box against many tile hitboxes one at a time, with
+ * SDL_HasIntersectionF over the tiles, against the batched kernels over the
+ * hitboxes as a structure of arrays.
+ *
+ * Usage: bench_aabb [Rounds]
+ *
+ * The boxes are tiles scattered over a level sized area, off the tile grid,
+ * and the tested boxes are character sized hitboxes scattered over it too.
+ */
+
+#include "SDL.h"
+#include "aabb.h"
+#include "arena.h"
+#include "bench.h"
+#include "rng.h"
+#include "tile.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_AABB_DEFAULT_ROUNDS 2000
+#define BENCH_AABB_QUERIES 256
+#define BENCH_AABB_TILE_SIZE 32
+#define BENCH_AABB_LEVEL_WIDTH 1024
+#define BENCH_AABB_LEVEL_HEIGHT 640
+#define BENCH_AABB_SEED 42
+
+// Keeps the compiler from optimizing the benchmarked work away.
+static volatile size_t bench_sink;
+
+typedef struct BenchSet
+{
+    size_t count;
+    Tile *tiles;
+    AabbArrays hitboxes;
+    SDL_FRect queries[BENCH_AABB_QUERIES];
+} BenchSet;
+
+static void bench_report(const char *what, const BenchSet *set, size_t rounds,
+                         double seconds)
+{
+    printf("  %-24s %6zu boxes %8.2f ns/query %8.3f ns/box\n", what,
+           set->count, seconds * 1e9 / ((double)rounds * BENCH_AABB_QUERIES),
+           seconds * 1e9 / ((double)rounds * BENCH_AABB_QUERIES * set->count));
+}
+
+static void bench_set_init(BenchSet *set, Arena *arena, Rng *rng,
+                           size_t count)
+{
+    set->count = count;
+    set->tiles = arena_alloc(arena, count * sizeof(Tile));
+    aabb_arrays_init(&set->hitboxes, arena, count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SDL_FRect hitbox = {
+            rng_below(rng, BENCH_AABB_LEVEL_WIDTH),
+            rng_below(rng, BENCH_AABB_LEVEL_HEIGHT),
+            BENCH_AABB_TILE_SIZE,
+            BENCH_AABB_TILE_SIZE,
+        };
+        tile_init(&set->tiles[i], hitbox, NULL, (TileCallback){0}, -1, 0,
+                  true);
+        aabb_arrays_set(&set->hitboxes, i, &hitbox);
+    }
+
+    for (size_t i = 0; i < BENCH_AABB_QUERIES; i++)
+    {
+        set->queries[i] = (SDL_FRect){
+            rng_below(rng, BENCH_AABB_LEVEL_WIDTH),
+            rng_below(rng, BENCH_AABB_LEVEL_HEIGHT),
+            BENCH_AABB_TILE_SIZE,
+            2 * BENCH_AABB_TILE_SIZE,
+        };
+    }
+}
+
+static void bench_tiles(const BenchSet *set, size_t rounds)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t q = 0; q < BENCH_AABB_QUERIES; q++)
+        {
+            for (size_t i = 0; i < set->count; i++)
+            {
+                bench_sink += SDL_HasIntersectionF(&set->queries[q],
+                                                   &set->tiles[i].hitbox);
+            }
+        }
+    }
+    bench_report("SDL_HasIntersectionF", set, rounds,
+                 bench_seconds_since(start));
+}
+
+static void bench_kernel(const BenchSet *set, size_t rounds,
+                         AabbIntersectFunction intersect, const char *what)
+{
+    size_t batch_count = aabb_batch_count(set->count);
+    Uint8 *masks = xmalloc(batch_count);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t q = 0; q < BENCH_AABB_QUERIES; q++)
+        {
+            intersect(&set->hitboxes, batch_count, &set->queries[q], masks);
+            for (size_t i = 0; i < batch_count; i++)
+            {
+                bench_sink += masks[i];
+            }
+        }
+    }
+    bench_report(what, set, rounds, bench_seconds_since(start));
+
+    free(masks);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10)
+                             : BENCH_AABB_DEFAULT_ROUNDS;
+    if (!rounds)
+        die("Usage: %s [Rounds]", argv[0]);
+
+    static const size_t counts[] = {16, 64, 256, 1024};
+    size_t max_count = counts[SDL_arraysize(counts) - 1];
+    Arena *arena = arena_create(ARENA_ALIGN(max_count * sizeof(Tile)) +
+                                aabb_arrays_arena_size(max_count));
+
+    Rng rng;
+    rng_seed(&rng, BENCH_AABB_SEED);
+
+    for (size_t i = 0; i < SDL_arraysize(counts); i++)
+    {
+        BenchSet set;
+        bench_set_init(&set, arena, &rng, counts[i]);
+
+        // The rounds are scaled so every set takes about as long.
+        size_t set_rounds = SDL_max(rounds * counts[0] / counts[i], 1);
+        printf("%zu boxes:\n", counts[i]);
+        bench_tiles(&set, set_rounds);
+        bench_kernel(&set, set_rounds, aabb_intersect_scalar, "scalar");
+#ifdef AABB_X86_KERNELS
+        if (SDL_HasSSE2())
+            bench_kernel(&set, set_rounds, aabb_intersect_sse2, "sse2");
+        if (SDL_HasAVX2())
+            bench_kernel(&set, set_rounds, aabb_intersect_avx2, "avx2");
+#endif
+
+        arena_reset(arena);
+    }
+
+    arena_destroy(arena);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/*
+ * Compares finding the overlapping pairs of moving bodies by testing every
+ * pair against the sweep and prune broadphase, kept from tick to tick and
+ * built from scratch every tick, and checks they all find the same pairs.
+ *
+ * Usage: bench_broadphase [Ticks]
+ *
+ * The bodies are enemy and projectile sized, scattered over a level sized
+ * area, and move a few pixels a tick, bouncing off its borders.
+ */
+
+#include "SDL.h"
+#include "bench.h"
+#include "broadphase.h"
+#include "physics_world.h"
+#include "rng.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_BROADPHASE_DEFAULT_TICKS 200
+#define BENCH_BROADPHASE_LEVEL_WIDTH 8192
+#define BENCH_BROADPHASE_LEVEL_HEIGHT 1536
+#define BENCH_BROADPHASE_MAX_SPEED 8
+#define BENCH_BROADPHASE_SEED 42
+
+static void bench_world_init(PhysicsWorld *world, size_t count)
+{
+    Rng rng;
+    rng_seed(&rng, BENCH_BROADPHASE_SEED);
+    for (size_t i = 0; i < count; i++)
+    {
+        // Every fourth body is a projectile, the rest are enemies.
+        SDL_FRect hitbox = {
+            rng_below(&rng, BENCH_BROADPHASE_LEVEL_WIDTH),
+            rng_below(&rng, BENCH_BROADPHASE_LEVEL_HEIGHT),
+            i % 4 ? 32 : 8,
+            i % 4 ? 64 : 8,
+        };
+        PhysicsBodyId body = physics_world_add_body(world, hitbox, 0);
+        world->velocity_x[body] =
+            (float)rng_below(&rng, 2 * BENCH_BROADPHASE_MAX_SPEED + 1) -
+            BENCH_BROADPHASE_MAX_SPEED;
+        world->velocity_y[body] =
+            (float)rng_below(&rng, 2 * BENCH_BROADPHASE_MAX_SPEED + 1) -
+            BENCH_BROADPHASE_MAX_SPEED;
+    }
+}
+
+static void bench_world_move(PhysicsWorld *world)
+{
+    for (size_t i = 0; i < world->count; i++)
+    {
+        world->x[i] += world->velocity_x[i];
+        world->y[i] += world->velocity_y[i];
+        if (world->x[i] < 0 || world->x[i] > BENCH_BROADPHASE_LEVEL_WIDTH)
+            world->velocity_x[i] = -world->velocity_x[i];
+        if (world->y[i] < 0 || world->y[i] > BENCH_BROADPHASE_LEVEL_HEIGHT)
+            world->velocity_y[i] = -world->velocity_y[i];
+    }
+}
+
+static void bench_brute_force(const PhysicsWorld *world,
+                              VecBroadphasePair *pairs)
+{
+    vector_resize(pairs, 0);
+    for (PhysicsBodyId a = 0; a < world->count; a++)
+    {
+        SDL_FRect a_hitbox = physics_world_get_hitbox(world, a);
+        for (PhysicsBodyId b = a + 1; b < world->count; b++)
+        {
+            SDL_FRect b_hitbox = physics_world_get_hitbox(world, b);
+            BroadphasePair pair = {a, b};
+            if (SDL_HasIntersectionF(&a_hitbox, &b_hitbox))
+                vector_add(pairs, pair);
+        }
+    }
+}
+
+static int bench_pair_compare(const void *a, const void *b)
+{
+    const BroadphasePair *pair_a = a, *pair_b = b;
+    if (pair_a->a != pair_b->a)
+        return pair_a->a < pair_b->a ? -1 : 1;
+    if (pair_a->b != pair_b->b)
+        return pair_a->b < pair_b->b ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief Checks if the two vectors have the same pairs, in any order.
+ */
+static bool bench_same_pairs(VecBroadphasePair expected,
+                             VecBroadphasePair found)
+{
+    if (vector_size(expected) != vector_size(found))
+        return false;
+
+    VecBroadphasePair sorted = vector_copy(found);
+    qsort(sorted, vector_size(sorted), sizeof(*sorted), bench_pair_compare);
+    bool same =
+        !memcmp(expected, sorted, vector_size(sorted) * sizeof(*sorted));
+    vector_free(sorted);
+
+    return same;
+}
+
+static void bench_report(const char *what, size_t ticks, double seconds)
+{
+    printf("  %-24s %10.3f us/tick\n", what, seconds * 1e6 / ticks);
+}
+
+static void bench_count(size_t count, size_t ticks)
+{
+    PhysicsWorld *world = physics_world_create(count);
+    bench_world_init(world, count);
+    Broadphase *broadphase = broadphase_create(count);
+    VecBroadphasePair expected = vector_create();
+
+    double brute_force_seconds = 0, incremental_seconds = 0,
+           rebuild_seconds = 0;
+    size_t pair_count = 0;
+    for (size_t tick = 0; tick < ticks; tick++)
+    {
+        bench_world_move(world);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        bench_brute_force(world, &expected);
+        brute_force_seconds += bench_seconds_since(start);
+
+        start = SDL_GetPerformanceCounter();
+        VecBroadphasePair pairs = broadphase_update(broadphase, world);
+        incremental_seconds += bench_seconds_since(start);
+        if (!bench_same_pairs(expected, pairs))
+            die("The broadphase missed pairs on tick %zu", tick);
+
+        start = SDL_GetPerformanceCounter();
+        Broadphase *rebuilt = broadphase_create(count);
+        pairs = broadphase_update(rebuilt, world);
+        rebuild_seconds += bench_seconds_since(start);
+        if (!bench_same_pairs(expected, pairs))
+            die("The rebuilt broadphase missed pairs on tick %zu", tick);
+        broadphase_destroy(rebuilt);
+
+        pair_count += vector_size(expected);
+    }
+
+    printf("%zu bodies, %.1f pairs/tick:\n", count,
+           (double)pair_count / ticks);
+    bench_report("every pair", ticks, brute_force_seconds);
+    bench_report("sweep and prune", ticks, incremental_seconds);
+    bench_report("sweep and prune, rebuilt", ticks, rebuild_seconds);
+
+    vector_free(expected);
+    broadphase_destroy(broadphase);
+    physics_world_destroy(world);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t ticks = argc > 1 ? strtoul(argv[1], NULL, 10)
+                            : BENCH_BROADPHASE_DEFAULT_TICKS;
+    if (!ticks)
+        die("Usage: %s [Ticks]", argv[0]);
+
+    static const size_t counts[] = {64, 256, 1024, 4096};
+    for (size_t i = 0; i < SDL_arraysize(counts); i++)
+    {
+        bench_count(counts[i], ticks);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+/*
+ * Compares the hashmap hash functions, and string keyed lookups with and
+ * without cached hashes.
+ *
+ * Usage: bench_hash [Rounds]
+ *
+ * The key sets resemble what the game hashes: level names, tile callback
+ * names, asset paths and keycodes.
+ */
+
+#include "SDL.h"
+#include "bench.h"
+#include "hashed_string.h"
+#include "hashmap.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_HASH_DEFAULT_ROUNDS 20000
+#define BENCH_HASH_MAX_KEYS 256
+#define BENCH_HASH_MAX_KEY_LEN 64
+
+typedef struct KeySet
+{
+    const char *name;
+    size_t count;
+    size_t key_len; // 0 for null terminated keys
+    char keys[BENCH_HASH_MAX_KEYS][BENCH_HASH_MAX_KEY_LEN];
+} KeySet;
+
+typedef HASHMAP(char, char) StringMap;
+typedef HASHMAP(HashedString, char) HashedStringMap;
+
+// Keeps the compiler from optimizing the benchmarked work away.
+static volatile size_t bench_sink;
+
+static void bench_report(const char *what, const KeySet *set, size_t rounds,
+                         double seconds)
+{
+    printf("  %-32s %-10s %8.2f ns/key\n", what, set->name,
+           seconds * 1e9 / ((double)rounds * set->count));
+}
+
+static void bench_hash_functions(const KeySet *set, size_t rounds)
+{
+    size_t lens[BENCH_HASH_MAX_KEYS];
+    for (size_t i = 0; i < set->count; i++)
+    {
+        lens[i] = set->key_len ? set->key_len : strlen(set->keys[i]);
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < set->count; i++)
+        {
+            bench_sink += hashmap_hash_default(set->keys[i], lens[i]);
+        }
+    }
+    bench_report("hashmap_hash_default", set, rounds,
+                 bench_seconds_since(start));
+
+    start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < set->count; i++)
+        {
+            bench_sink += hashmap_hash_fast(set->keys[i], lens[i]);
+        }
+    }
+    bench_report("hashmap_hash_fast", set, rounds, bench_seconds_since(start));
+}
+
+static void bench_string_lookups(const KeySet *set, size_t rounds,
+                                 size_t (*hash_func)(const char *),
+                                 const char *what)
+{
+    StringMap map;
+    hashmap_init(&map, hash_func, strcmp);
+    for (size_t i = 0; i < set->count; i++)
+    {
+        hashmap_put(&map, set->keys[i], (char *)set->keys[i]);
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < set->count; i++)
+        {
+            bench_sink += (size_t)hashmap_get(&map, set->keys[i]);
+        }
+    }
+    bench_report(what, set, rounds, bench_seconds_since(start));
+
+    hashmap_cleanup(&map);
+}
+
+static void bench_hashed_string_lookups(const KeySet *set, size_t rounds)
+{
+    HashedString keys[BENCH_HASH_MAX_KEYS];
+    HashedStringMap map;
+    hashmap_init(&map, hashed_string_hash, hashed_string_compare);
+    for (size_t i = 0; i < set->count; i++)
+    {
+        keys[i] = hashed_string_make(set->keys[i]);
+        hashmap_put(&map, &keys[i], (char *)set->keys[i]);
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t round = 0; round < rounds; round++)
+    {
+        for (size_t i = 0; i < set->count; i++)
+        {
+            bench_sink += (size_t)hashmap_get(&map, &keys[i]);
+        }
+    }
+    bench_report("get (HashedString)", set, rounds,
+                 bench_seconds_since(start));
+
+    hashmap_cleanup(&map);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t rounds = argc > 1 ? strtoul(argv[1], NULL, 10)
+                             : BENCH_HASH_DEFAULT_ROUNDS;
+    if (!rounds)
+        die("Usage: %s [Rounds]", argv[0]);
+
+    static KeySet sets[4] = {
+        {.name = "levels", .count = 16},
+        {.name = "callbacks", .count = 2},
+        {.name = "paths", .count = 128},
+        {.name = "keycodes", .count = 64, .key_len = sizeof(SDL_Keycode)},
+    };
+
+    for (size_t i = 0; i < sets[0].count; i++)
+    {
+        snprintf(sets[0].keys[i], BENCH_HASH_MAX_KEY_LEN, "level%zu", i);
+    }
+    strcpy(sets[1].keys[0], "");
+    strcpy(sets[1].keys[1], "ladder");
+    for (size_t i = 0; i < sets[2].count; i++)
+    {
+        snprintf(sets[2].keys[i], BENCH_HASH_MAX_KEY_LEN,
+                 "assets/textures/tileset/tile_%03zu.png", i);
+    }
+    // Keycodes are hashed as their bytes.
+    for (size_t i = 0; i < sets[3].count; i++)
+    {
+        SDL_Keycode key = (i % 2 ? 'a' : SDLK_SCANCODE_MASK) + i;
+        memcpy(sets[3].keys[i], &key, sizeof(key));
+    }
+
+    printf("Hash functions:\n");
+    for (size_t i = 0; i < SDL_arraysize(sets); i++)
+    {
+        bench_hash_functions(&sets[i], rounds);
+    }
+
+    printf("String keyed lookups:\n");
+    for (size_t i = 0; i < SDL_arraysize(sets); i++)
+    {
+        if (sets[i].key_len)
+            continue;
+
+        bench_string_lookups(&sets[i], rounds, hashmap_hash_string,
+                             "get (hashmap_hash_string)");
+        bench_string_lookups(&sets[i], rounds, hashmap_hash_string_fast,
+                             "get (hashmap_hash_string_fast)");
+        bench_hashed_string_lookups(&sets[i], rounds);
+    }
+
+    return EXIT_SUCCESS;
+}
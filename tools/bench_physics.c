@@ -0,0 +1,204 @@
+/*
+ * Measures stepping a physics world full of bodies on 1, 2, 4, 8... threads
+ * (up to at least 8, or the amount of CPUs), and checks every run ends in
+ * exactly the same state as the one on a single thread.
+ *
+ * Usage: bench_physics [Bodies] [Steps]
+ *
+ * The level is a floor with platforms scattered above it, and the bodies are
+ * enemy sized, start all over it, walk and jump now and then.
+ */
+
+#include "SDL.h"
+#include "arena.h"
+#include "bench.h"
+#include "collision_mesh.h"
+#include "job_system.h"
+#include "level_layer.h"
+#include "physics_world.h"
+#include "rng.h"
+#include "solid_bitmap.h"
+#include "tile.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_PHYSICS_DEFAULT_BODIES 4096
+#define BENCH_PHYSICS_DEFAULT_STEPS 600
+#define BENCH_PHYSICS_MIN_THREADS 8
+#define BENCH_PHYSICS_TILE_SIZE 32
+#define BENCH_PHYSICS_COLUMNS 256
+#define BENCH_PHYSICS_ROWS 48
+#define BENCH_PHYSICS_PLATFORMS 600
+#define BENCH_PHYSICS_PLATFORM_TILES 4
+#define BENCH_PHYSICS_SEED 42
+#define BENCH_PHYSICS_GRAVITY 0.9f
+#define BENCH_PHYSICS_MAX_VELOCITY BENCH_PHYSICS_TILE_SIZE
+#define BENCH_PHYSICS_SPEED 3
+#define BENCH_PHYSICS_JUMP_STRENGTH 20
+// Every body jumps once in this many steps, if it's on the ground.
+#define BENCH_PHYSICS_JUMP_PERIOD 90
+
+static void bench_add_tile(LevelLayer *layer, int column, int row)
+{
+    Tile tile;
+    SDL_FRect hitbox = {
+        column * BENCH_PHYSICS_TILE_SIZE,
+        row * BENCH_PHYSICS_TILE_SIZE,
+        BENCH_PHYSICS_TILE_SIZE,
+        BENCH_PHYSICS_TILE_SIZE,
+    };
+    tile_init(&tile, hitbox, NULL, (TileCallback){0}, -1, 0, true);
+    level_layer_add_tile(layer, tile);
+}
+
+static LevelLayer *bench_layer_create(Arena *arena, Rng *rng)
+{
+    LevelLayer *layer = level_layer_create(
+        arena, BENCH_PHYSICS_COLUMNS +
+                   BENCH_PHYSICS_PLATFORMS * BENCH_PHYSICS_PLATFORM_TILES);
+
+    for (int column = 0; column < BENCH_PHYSICS_COLUMNS; column++)
+    {
+        bench_add_tile(layer, column, BENCH_PHYSICS_ROWS - 1);
+    }
+
+    for (int i = 0; i < BENCH_PHYSICS_PLATFORMS; i++)
+    {
+        int column = rng_below(rng, BENCH_PHYSICS_COLUMNS -
+                                        BENCH_PHYSICS_PLATFORM_TILES);
+        int row = rng_below(rng, BENCH_PHYSICS_ROWS - 1);
+        for (int j = 0; j < BENCH_PHYSICS_PLATFORM_TILES; j++)
+        {
+            bench_add_tile(layer, column + j, row);
+        }
+    }
+
+    return layer;
+}
+
+/**
+ * @brief Creates the world every run starts from, the same each time.
+ */
+static PhysicsWorld *bench_world_create(size_t body_count)
+{
+    PhysicsWorld *world = physics_world_create(body_count);
+
+    Rng rng;
+    rng_seed(&rng, BENCH_PHYSICS_SEED);
+    for (size_t i = 0; i < body_count; i++)
+    {
+        SDL_FRect hitbox = {
+            rng_below(&rng, BENCH_PHYSICS_COLUMNS * BENCH_PHYSICS_TILE_SIZE),
+            rng_below(&rng, BENCH_PHYSICS_ROWS * BENCH_PHYSICS_TILE_SIZE),
+            BENCH_PHYSICS_TILE_SIZE,
+            2 * BENCH_PHYSICS_TILE_SIZE,
+        };
+        PhysicsBodyId body =
+            physics_world_add_body(world, hitbox, BENCH_PHYSICS_SPEED);
+        world->movement_direction[body] = rng_below(&rng, 3);
+    }
+
+    return world;
+}
+
+static bool bench_worlds_equal(const PhysicsWorld *a, const PhysicsWorld *b)
+{
+    size_t floats_size = a->count * sizeof(float);
+    return a->count == b->count && !memcmp(a->x, b->x, floats_size) &&
+           !memcmp(a->y, b->y, floats_size) &&
+           !memcmp(a->velocity_x, b->velocity_x, floats_size) &&
+           !memcmp(a->velocity_y, b->velocity_y, floats_size) &&
+           !memcmp(a->collisions, b->collisions, a->count);
+}
+
+/**
+ * @brief Steps a new world on the given amount of threads.
+ *
+ * @return The world after the steps.
+ */
+static PhysicsWorld *bench_run(int thread_count, size_t body_count,
+                               size_t steps, const CollisionMesh *mesh,
+                               const SolidBitmap *bitmap, double *seconds)
+{
+    JobSystem *jobs = job_system_create(thread_count);
+    PhysicsWorld *world = bench_world_create(body_count);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (size_t step = 0; step < steps; step++)
+    {
+        for (size_t i = step % BENCH_PHYSICS_JUMP_PERIOD; i < world->count;
+             i += BENCH_PHYSICS_JUMP_PERIOD)
+        {
+            if (world->collisions[i] & PHYSICS_COLLISION_BOTTOM)
+                world->velocity_y[i] -= BENCH_PHYSICS_JUMP_STRENGTH;
+        }
+
+        physics_world_step(world, mesh, bitmap, BENCH_PHYSICS_GRAVITY,
+                           BENCH_PHYSICS_MAX_VELOCITY, jobs);
+    }
+    *seconds = bench_seconds_since(start);
+
+    job_system_destroy(jobs);
+
+    return world;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t body_count = argc > 1 ? strtoul(argv[1], NULL, 10)
+                                 : BENCH_PHYSICS_DEFAULT_BODIES;
+    size_t steps = argc > 2 ? strtoul(argv[2], NULL, 10)
+                            : BENCH_PHYSICS_DEFAULT_STEPS;
+    if (!body_count || !steps)
+        die("Usage: %s [Bodies] [Steps]", argv[0]);
+
+    size_t tile_capacity = BENCH_PHYSICS_COLUMNS +
+                           BENCH_PHYSICS_PLATFORMS *
+                               BENCH_PHYSICS_PLATFORM_TILES;
+    Arena *arena = arena_create(level_layer_arena_size(tile_capacity));
+
+    Rng rng;
+    rng_seed(&rng, BENCH_PHYSICS_SEED);
+    VecLevelLayer layers = vector_create();
+    LevelLayer *layer = bench_layer_create(arena, &rng);
+    // NOLINTNEXTLINE(bugprone-sizeof-expression)
+    vector_add(&layers, layer);
+
+    SDL_FPoint cell_size = {BENCH_PHYSICS_TILE_SIZE, BENCH_PHYSICS_TILE_SIZE};
+    CollisionMesh *mesh = collision_mesh_create(layers, cell_size);
+    SolidBitmap *bitmap = solid_bitmap_create(layers, cell_size);
+
+    printf("%zu bodies, %zu steps, %zu collision rects:\n", body_count, steps,
+           vector_size(mesh->rects->tiles));
+
+    double reference_seconds;
+    PhysicsWorld *reference =
+        bench_run(1, body_count, steps, mesh, bitmap, &reference_seconds);
+
+    int max_threads = SDL_max(SDL_GetCPUCount(), BENCH_PHYSICS_MIN_THREADS);
+    for (int thread_count = 1; thread_count <= max_threads; thread_count *= 2)
+    {
+        double seconds;
+        PhysicsWorld *world =
+            bench_run(thread_count, body_count, steps, mesh, bitmap, &seconds);
+
+        bool identical = bench_worlds_equal(world, reference);
+        printf("  %2d threads %10.3f ms/step %6.2fx %s\n", thread_count,
+               seconds * 1e3 / steps, reference_seconds / seconds,
+               identical ? "identical" : "DIFFERENT");
+        if (!identical)
+            die("Stepping on %d threads changed the result", thread_count);
+
+        physics_world_destroy(world);
+    }
+
+    physics_world_destroy(reference);
+    solid_bitmap_destroy(bitmap);
+    collision_mesh_destroy(mesh);
+    vector_free(layers);
+    arena_destroy(arena);
+
+    return EXIT_SUCCESS;
+}
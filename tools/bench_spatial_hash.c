@@ -0,0 +1,215 @@
+/*
+ * Compares "what's near me" queries over moving objects by scanning all of
+ * them against the spatial hash, and checks both find the same objects.
+ *
+ * Usage: bench_spatial_hash [Ticks]
+ *
+ * The objects are item and enemy sized, scattered over a level sized area,
+ * move a few pixels a tick, and some of them are removed and inserted again
+ * every tick. The queries are light sized radii and screen sized areas.
+ */
+
+#include "SDL.h"
+#include "bench.h"
+#include "rng.h"
+#include "spatial_hash.h"
+#include "utils.h"
+#include "vec.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_SPATIAL_HASH_DEFAULT_TICKS 100
+#define BENCH_SPATIAL_HASH_QUERIES 64
+#define BENCH_SPATIAL_HASH_CELL_SIZE 64
+#define BENCH_SPATIAL_HASH_LEVEL_WIDTH 16384
+#define BENCH_SPATIAL_HASH_LEVEL_HEIGHT 2048
+#define BENCH_SPATIAL_HASH_MAX_SPEED 4
+#define BENCH_SPATIAL_HASH_RADIUS 160
+#define BENCH_SPATIAL_HASH_AREA_WIDTH 800
+#define BENCH_SPATIAL_HASH_AREA_HEIGHT 600
+// One in this many objects is removed and inserted again each tick.
+#define BENCH_SPATIAL_HASH_CHURN 32
+#define BENCH_SPATIAL_HASH_SEED 42
+
+typedef struct BenchObject
+{
+    SDL_FRect box;
+    SDL_FPoint velocity;
+    SpatialHashHandle handle;
+} BenchObject;
+
+static void bench_objects_init(BenchObject *objects, size_t count,
+                               SpatialHash *hash, Rng *rng)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        BenchObject *object = &objects[i];
+        // Every fourth object is an enemy, the rest are items.
+        object->box = (SDL_FRect){
+            rng_below(rng, BENCH_SPATIAL_HASH_LEVEL_WIDTH),
+            rng_below(rng, BENCH_SPATIAL_HASH_LEVEL_HEIGHT),
+            i % 4 ? 16 : 32,
+            i % 4 ? 16 : 64,
+        };
+        object->velocity = (SDL_FPoint){
+            (float)rng_below(rng, 2 * BENCH_SPATIAL_HASH_MAX_SPEED + 1) -
+                BENCH_SPATIAL_HASH_MAX_SPEED,
+            (float)rng_below(rng, 2 * BENCH_SPATIAL_HASH_MAX_SPEED + 1) -
+                BENCH_SPATIAL_HASH_MAX_SPEED,
+        };
+        object->handle = spatial_hash_insert(hash, object->box, object);
+    }
+}
+
+static void bench_objects_move(BenchObject *objects, size_t count,
+                               SpatialHash *hash, size_t tick)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        BenchObject *object = &objects[i];
+        object->box.x += object->velocity.x;
+        object->box.y += object->velocity.y;
+        if (object->box.x < 0 ||
+            object->box.x > BENCH_SPATIAL_HASH_LEVEL_WIDTH)
+            object->velocity.x = -object->velocity.x;
+        if (object->box.y < 0 ||
+            object->box.y > BENCH_SPATIAL_HASH_LEVEL_HEIGHT)
+            object->velocity.y = -object->velocity.y;
+
+        if (i % BENCH_SPATIAL_HASH_CHURN == tick % BENCH_SPATIAL_HASH_CHURN)
+        {
+            spatial_hash_remove(hash, object->handle);
+            object->handle = spatial_hash_insert(hash, object->box, object);
+        }
+        else
+        {
+            spatial_hash_move(hash, object->handle, object->box);
+        }
+    }
+}
+
+/**
+ * @brief Checks if the hash found exactly the objects the scan did.
+ */
+static bool bench_same_objects(const SpatialHash *hash,
+                               VecSpatialHashHandle found,
+                               const BenchObject *objects,
+                               const bool *expected, size_t expected_count)
+{
+    if (vector_size(found) != expected_count)
+        return false;
+
+    vector_iter(handle, found)
+    {
+        const BenchObject *object = spatial_hash_get(hash, *handle)->data;
+        if (object->handle != *handle || !expected[object - objects])
+            return false;
+    }
+
+    return true;
+}
+
+static void bench_count(size_t count, size_t ticks, Rng *rng)
+{
+    BenchObject *objects = xmalloc(count * sizeof(*objects));
+    bool *expected = xmalloc(count * sizeof(*expected));
+    SpatialHash *hash = spatial_hash_create((SDL_FPoint){
+        BENCH_SPATIAL_HASH_CELL_SIZE, BENCH_SPATIAL_HASH_CELL_SIZE});
+    bench_objects_init(objects, count, hash, rng);
+    VecSpatialHashHandle found = vector_create();
+
+    double move_seconds = 0, scan_seconds = 0, hash_seconds = 0;
+    size_t found_count = 0;
+    for (size_t tick = 0; tick < ticks; tick++)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        bench_objects_move(objects, count, hash, tick);
+        move_seconds += bench_seconds_since(start);
+
+        for (size_t q = 0; q < BENCH_SPATIAL_HASH_QUERIES; q++)
+        {
+            SDL_FPoint center = {
+                rng_below(rng, BENCH_SPATIAL_HASH_LEVEL_WIDTH),
+                rng_below(rng, BENCH_SPATIAL_HASH_LEVEL_HEIGHT),
+            };
+            SDL_FRect area = {
+                center.x - BENCH_SPATIAL_HASH_AREA_WIDTH / 2.0f,
+                center.y - BENCH_SPATIAL_HASH_AREA_HEIGHT / 2.0f,
+                BENCH_SPATIAL_HASH_AREA_WIDTH,
+                BENCH_SPATIAL_HASH_AREA_HEIGHT,
+            };
+            bool is_radius = q % 2;
+
+            start = SDL_GetPerformanceCounter();
+            size_t expected_count = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                const SDL_FRect *box = &objects[i].box;
+                float dx = SDL_max(SDL_max(box->x - center.x,
+                                           center.x - (box->x + box->w)),
+                                   0);
+                float dy = SDL_max(SDL_max(box->y - center.y,
+                                           center.y - (box->y + box->h)),
+                                   0);
+                expected[i] =
+                    is_radius ? dx * dx + dy * dy <=
+                                    BENCH_SPATIAL_HASH_RADIUS *
+                                        BENCH_SPATIAL_HASH_RADIUS
+                              : SDL_HasIntersectionF(box, &area);
+                expected_count += expected[i];
+            }
+            scan_seconds += bench_seconds_since(start);
+
+            vector_resize(&found, 0);
+            start = SDL_GetPerformanceCounter();
+            if (is_radius)
+            {
+                spatial_hash_query_radius(hash, center,
+                                          BENCH_SPATIAL_HASH_RADIUS, &found);
+            }
+            else
+            {
+                spatial_hash_query_rect(hash, &area, &found);
+            }
+            hash_seconds += bench_seconds_since(start);
+
+            if (!bench_same_objects(hash, found, objects, expected,
+                                    expected_count))
+                die("The spatial hash found other objects on tick %zu", tick);
+            found_count += expected_count;
+        }
+    }
+
+    size_t queries = ticks * BENCH_SPATIAL_HASH_QUERIES;
+    printf("%zu objects, %.1f found/query:\n", count,
+           (double)found_count / queries);
+    printf("  %-24s %10.3f us/tick\n", "moving", move_seconds * 1e6 / ticks);
+    printf("  %-24s %10.3f us/query\n", "scanning every object",
+           scan_seconds * 1e6 / queries);
+    printf("  %-24s %10.3f us/query\n", "spatial hash",
+           hash_seconds * 1e6 / queries);
+
+    vector_free(found);
+    spatial_hash_destroy(hash);
+    free(expected);
+    free(objects);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t ticks = argc > 1 ? strtoul(argv[1], NULL, 10)
+                            : BENCH_SPATIAL_HASH_DEFAULT_TICKS;
+    if (!ticks)
+        die("Usage: %s [Ticks]", argv[0]);
+
+    Rng rng;
+    rng_seed(&rng, BENCH_SPATIAL_HASH_SEED);
+
+    static const size_t counts[] = {256, 1024, 4096, 16384};
+    for (size_t i = 0; i < SDL_arraysize(counts); i++)
+    {
+        bench_count(counts[i], ticks, &rng);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*
+ * Packs asset files and directories into a single asset pack.
+ *
+ * Usage: packer <Output pack path> <File or directory path>...
+ *
+ * Directories are packed recursively. Entries are stored under the paths they
+ * were found at (normalized), so the pack should be created from the same
+ * working directory the game is started from, e.g.
+ *      bin/packer assets.pack assets
+ *      bin/game -p assets.pack assets/textures/... assets/...
+ */
+
+#include "SDL.h"
+#include "dir.h"
+#include "pack.h"
+#include "utils.h"
+#include "vec.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+typedef struct PackerEntry
+{
+    char *path; // Normalized
+    PackEntry entry;
+} PackerEntry;
+
+typedef PackerEntry *VecPackerEntry;
+
+static uint64_t packer_align(uint64_t offset)
+{
+    return (offset + PACK_ALIGNMENT - 1) & ~(uint64_t)(PACK_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Adds the file at path, or all the files under it if it's a directory.
+ */
+static void packer_collect(VecPackerEntry *entries, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0)
+        die("stat %s: %s", path, strerror(errno));
+
+    if (S_ISREG(st.st_mode))
+    {
+        char normalized_path[PACK_PATH_MAX];
+        if (!pack_normalize_path(path, normalized_path,
+                                 sizeof(normalized_path)))
+            die("Path %s is too long", path);
+
+        PackerEntry packer_entry = {
+            .path = strdup(normalized_path),
+            .entry =
+                {
+                    .path_hash = pack_hash_path(normalized_path),
+                    .length = st.st_size,
+                    .compression = PACK_COMPRESSION_NONE,
+                },
+        };
+        vector_add(entries, packer_entry);
+        return;
+    }
+
+    if (!S_ISDIR(st.st_mode))
+        return;
+
+    DIR *dir = opendir(path);
+    if (!dir)
+        die("Opening directory %s failed", path);
+
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir)))
+    {
+        if (strcmp(dir_entry->d_name, ".") == 0 ||
+            strcmp(dir_entry->d_name, "..") == 0)
+            continue;
+
+        char *entry_path = dir_get_path_to_entry(dir_entry, path);
+        packer_collect(entries, entry_path);
+        free(entry_path);
+    }
+
+    closedir(dir);
+}
+
+static int packer_compare_entries(const void *a, const void *b)
+{
+    const PackerEntry *entry_a = a;
+    const PackerEntry *entry_b = b;
+
+    if (entry_a->entry.path_hash != entry_b->entry.path_hash)
+        return entry_a->entry.path_hash < entry_b->entry.path_hash ? -1 : 1;
+
+    return strcmp(entry_a->path, entry_b->path);
+}
+
+static void packer_write(FILE *stream, const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, stream) != size)
+        die("Writing the pack failed: %s", strerror(errno));
+}
+
+static void packer_pad_to(FILE *stream, uint64_t offset)
+{
+    static const char zeros[PACK_ALIGNMENT] = {0};
+
+    long position = ftell(stream);
+    SDL_assert(position >= 0 && (uint64_t)position <= offset);
+
+    packer_write(stream, zeros, offset - position);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+        die("Usage: %s <Output pack path> <File or directory path>...",
+            argv[0]);
+
+    VecPackerEntry entries = vector_create();
+    for (int i = 2; i < argc; i++)
+    {
+        packer_collect(&entries, argv[i]);
+    }
+
+    size_t entry_count = vector_size(entries);
+    qsort(entries, entry_count, sizeof(*entries), packer_compare_entries);
+
+    for (size_t i = 1; i < entry_count; i++)
+    {
+        if (strcmp(entries[i - 1].path, entries[i].path) == 0)
+            die("%s was given more than once", entries[i].path);
+    }
+
+    /* Lay out the pack: the header, the TOC and the strings, and then the
+     * aligned data of each entry. */
+    PackHeader header = {
+        .version = PACK_VERSION,
+        .entry_count = entry_count,
+        .toc_offset = sizeof(PackHeader),
+        .strings_offset = sizeof(PackHeader) + entry_count * sizeof(PackEntry),
+    };
+    memcpy(header.magic, PACK_MAGIC, PACK_MAGIC_SIZE);
+
+    uint64_t strings_size = 0;
+    vector_iter(packer_entry, entries)
+    {
+        packer_entry->entry.path_offset = strings_size;
+        strings_size += strlen(packer_entry->path) + 1;
+    }
+
+    uint64_t data_offset = packer_align(header.strings_offset + strings_size);
+    vector_iter(packer_entry, entries)
+    {
+        packer_entry->entry.offset = data_offset;
+        data_offset = packer_align(data_offset + packer_entry->entry.length);
+    }
+
+    FILE *pack_file = fopen(argv[1], "wb");
+    if (!pack_file)
+        die("Opening file %s failed", argv[1]);
+
+    packer_write(pack_file, &header, sizeof(header));
+
+    vector_iter(packer_entry, entries)
+    {
+        packer_write(pack_file, &packer_entry->entry,
+                     sizeof(packer_entry->entry));
+    }
+
+    vector_iter(packer_entry, entries)
+    {
+        packer_write(pack_file, packer_entry->path,
+                     strlen(packer_entry->path) + 1);
+    }
+
+    char buf[PACK_ALIGNMENT];
+    vector_iter(packer_entry, entries)
+    {
+        packer_pad_to(pack_file, packer_entry->entry.offset);
+
+        FILE *entry_file = fopen(packer_entry->path, "rb");
+        if (!entry_file)
+            die("Opening file %s failed", packer_entry->path);
+
+        uint64_t bytes_left = packer_entry->entry.length;
+        size_t bytes_read = 0;
+        while (bytes_left > 0 &&
+               (bytes_read = fread(buf, 1, sizeof(buf), entry_file)) > 0)
+        {
+            packer_write(pack_file, buf, SDL_min(bytes_read, bytes_left));
+            bytes_left -= SDL_min(bytes_read, bytes_left);
+        }
+
+        if (bytes_left > 0)
+            die("%s changed while packing", packer_entry->path);
+
+        fclose(entry_file);
+        free(packer_entry->path);
+    }
+
+    if (fclose(pack_file) != 0)
+        die("Writing the pack failed: %s", strerror(errno));
+
+    SDL_Log("Packed %zu files into %s", entry_count, argv[1]);
+
+    vector_free(entries);
+
+    return EXIT_SUCCESS;
+}